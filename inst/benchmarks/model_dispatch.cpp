@@ -0,0 +1,548 @@
+/**
+ * Micro-benchmark of the model dispatch in Estimator: the per-model functions selected by comparing
+ * questionSet.model on every call ("string dispatch", as the package did before the policies of ModelPolicy.h),
+ * against the policy templates selected once when the Estimator is built ("policy dispatch").
+ *
+ * The legacy side is a copy of the old Estimator code, with the thresholds in one std::vector per item; the
+ * policy side mirrors Estimator::sumAnswers over the flattened ThresholdTable. Both evaluate the log-likelihood
+ * and its first and second derivatives for a respondent who has answered `answered` items of a synthetic bank,
+ * and the benchmark checks that they agree before timing them.
+ *
+ * The benchmark only needs the header-only src/ModelPolicy.h and src/ProbabilityKernels.h. From the package root:
+ *
+ *   g++ -O2 -std=c++11 -Isrc inst/benchmarks/model_dispatch.cpp -o model_dispatch
+ *   ./model_dispatch [items] [answered] [evaluations]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "ModelPolicy.h"
+
+void model::extreme_theta(double theta) {
+	throw std::domain_error("Theta value " + std::to_string(theta) + " too extreme");
+}
+
+static const double eps = kernels::eps;
+
+struct Bank {
+	std::string model;
+	std::vector<std::vector<double> > difficulty;
+	std::vector<double> values;
+	std::vector<size_t> offsets;
+	std::vector<double> discrimination;
+	std::vector<double> guessing;
+	std::vector<int> answers;
+	std::vector<int> applicable_rows;
+};
+
+static Bank make_bank(const std::string &model, size_t items, size_t answered, std::mt19937 &rng) {
+	std::uniform_real_distribution<double> discrimination(0.5, 2.5);
+	std::uniform_real_distribution<double> location(-2.0, 2.0);
+	std::uniform_real_distribution<double> guessing(0.0, 0.25);
+	std::uniform_int_distribution<int> thresholds(2, 5);
+
+	Bank bank;
+	bank.model = model;
+	bank.offsets.push_back(0);
+	for (size_t j = 0; j < items; ++j) {
+		std::vector<double> item;
+		if (model == "ltm" || model == "tpm") {
+			item.push_back(location(rng));
+		} else {
+			int count = thresholds(rng);
+			for (int k = 0; k < count; ++k) {
+				item.push_back(location(rng));
+			}
+			if (model == "grm") {
+				std::sort(item.begin(), item.end());
+			}
+		}
+		bank.difficulty.push_back(item);
+		bank.values.insert(bank.values.end(), item.begin(), item.end());
+		bank.offsets.push_back(bank.values.size());
+		bank.discrimination.push_back(discrimination(rng));
+		bank.guessing.push_back(model == "tpm" ? guessing(rng) : 0.0);
+	}
+
+	bank.answers.assign(items, -9);
+	for (size_t j = 0; j < answered; ++j) {
+		size_t question = (j * 7) % items;
+		int lowest = (model == "ltm" || model == "tpm") ? 0 : 1;
+		int highest = (int) bank.difficulty[question].size() + ((model == "ltm" || model == "tpm") ? 0 : 1);
+		bank.answers[question] = std::uniform_int_distribution<int>(lowest, highest)(rng);
+		bank.applicable_rows.push_back((int) question);
+	}
+	return bank;
+}
+
+/**
+ * The Estimator code before the policies: one function per model, picked by string comparison on every call.
+ */
+struct LegacyEstimator {
+	const Bank &questionSet;
+
+	double prob_ltm(double theta, size_t question) {
+		if (theta > 20.0 || theta < -20.0) {
+			model::extreme_theta(theta);
+		}
+		double difficulty = questionSet.difficulty.at(question).at(0);
+		double exp_prob_bi = exp(difficulty + (questionSet.discrimination.at(question) * theta));
+		if (std::isinf(exp_prob_bi)) {
+			return 1.0 - eps;
+		}
+		double guess = questionSet.guessing.at(question);
+		double result = guess + (1 - guess) * (exp_prob_bi / (1 + exp_prob_bi));
+		if (result > (1.0 - eps)) {
+			result = 1.0 - eps;
+		} else if (result < eps) {
+			result = eps;
+		}
+		return result;
+	}
+
+	struct GrmProb {
+		GrmProb(double theta, double discrimination) : theta_desc(theta * discrimination) {}
+
+		double operator()(double difficulty) const {
+			double exp_prob = exp(difficulty - theta_desc);
+			if (std::isinf(exp_prob)) {
+				return 1.0 - eps;
+			}
+			double result = exp_prob / (1 + exp_prob);
+			if (result > (1.0 - eps)) {
+				result = 1.0 - eps;
+			} else if (result < eps) {
+				result = eps;
+			}
+			return result;
+		}
+
+		double theta_desc;
+	};
+
+	std::pair<double, double> prob_grm_pair(double theta, size_t question, size_t at) {
+		GrmProb calculate{theta, questionSet.discrimination.at(question)};
+		std::pair<double, double> probs;
+		const std::vector<double> &difficulties = questionSet.difficulty.at(question);
+		probs.first = at == 1 ? 0.0 : calculate(difficulties[at - 2]);
+		probs.second = at == difficulties.size() + 1 ? 1.0 : calculate(difficulties[at - 1]);
+		if (probs.first == probs.second) {
+			model::extreme_theta(theta);
+		}
+		return probs;
+	}
+
+	double prob_gpcm_at(double theta, size_t question, size_t at) {
+		double discrimination = questionSet.discrimination.at(question);
+		const std::vector<double> &categoryparams = questionSet.difficulty.at(question);
+		double sum = discrimination * theta;
+		double denominator = exp(sum);
+		double result = -1;
+		if (at == 0) {
+			result = denominator;
+			for (auto cat : categoryparams) {
+				sum += discrimination * (theta - cat);
+				denominator += exp(sum);
+			}
+		} else {
+			at -= 1;
+			for (size_t i = 0; i != at; ++i) {
+				sum += discrimination * (theta - categoryparams[i]);
+				denominator += exp(sum);
+			}
+			sum += discrimination * (theta - categoryparams[at]);
+			result = exp(sum);
+			denominator += result;
+			for (size_t i = at + 1; i < categoryparams.size(); ++i) {
+				sum += discrimination * (theta - categoryparams[i]);
+				denominator += exp(sum);
+			}
+		}
+		if (denominator == 0.0 || std::isinf(denominator)) {
+			model::extreme_theta(theta);
+		}
+		return result / denominator;
+	}
+
+	double gpcm_partial_d1LL(double theta, size_t question, int answer) {
+		size_t index = ((size_t) answer) - 1;
+		double discrimination = questionSet.discrimination.at(question);
+		const std::vector<double> &categoryparams = questionSet.difficulty.at(question);
+		double f = -1;
+		double f_prime = -1;
+		double sum = discrimination * (theta - 0.0);
+		double g = exp(sum);
+		double x = discrimination;
+		double g_prime = g * x;
+		if (index == 0) {
+			f = g;
+			f_prime = g_prime;
+			for (auto cat : categoryparams) {
+				sum += discrimination * (theta - cat);
+				double num = exp(sum);
+				x += discrimination;
+				g += num;
+				g_prime += num * x;
+			}
+		} else {
+			index -= 1;
+			for (size_t i = 0; i != index; ++i) {
+				sum += discrimination * (theta - categoryparams[i]);
+				double num = exp(sum);
+				x += discrimination;
+				g += num;
+				g_prime += num * x;
+			}
+			sum += discrimination * (theta - categoryparams[index]);
+			f = exp(sum);
+			x += discrimination;
+			f_prime = f * x;
+			g += f;
+			g_prime += f_prime;
+			for (size_t i = index + 1; i < categoryparams.size(); ++i) {
+				sum += discrimination * (theta - categoryparams[i]);
+				double num = exp(sum);
+				x += discrimination;
+				g += num;
+				g_prime += num * x;
+			}
+		}
+		if (g == 0.0 || std::isinf(g)) {
+			model::extreme_theta(theta);
+		}
+		return (g * f_prime - f * g_prime) / (g * f);
+	}
+
+	double gpcm_partial_d2LL(double theta, size_t question, int answer) {
+		size_t index = ((size_t) answer) - 1;
+		double discrimination = questionSet.discrimination.at(question);
+		const std::vector<double> &categoryparams = questionSet.difficulty.at(question);
+		double f = -1;
+		double f_prime = -1;
+		double f_primeprime = -1;
+		double sum = discrimination * (theta - 0.0);
+		double g = exp(sum);
+		double x = discrimination;
+		double g_prime = g * x;
+		double g_primeprime = g_prime * x;
+		if (index == 0) {
+			f = g;
+			f_prime = g_prime;
+			f_primeprime = g_primeprime;
+			for (auto cat : categoryparams) {
+				sum += discrimination * (theta - cat);
+				double num = exp(sum);
+				x += discrimination;
+				double num_x = num * x;
+				g += num;
+				g_prime += num_x;
+				g_primeprime += num_x * x;
+			}
+		} else {
+			index -= 1;
+			for (size_t i = 0; i != index; ++i) {
+				sum += discrimination * (theta - categoryparams[i]);
+				double num = exp(sum);
+				x += discrimination;
+				double num_x = num * x;
+				g += num;
+				g_prime += num_x;
+				g_primeprime += num_x * x;
+			}
+			sum += discrimination * (theta - categoryparams[index]);
+			f = exp(sum);
+			x += discrimination;
+			f_prime = f * x;
+			f_primeprime = f_prime * x;
+			g += f;
+			g_prime += f_prime;
+			g_primeprime += f_primeprime;
+			for (size_t i = index + 1; i < categoryparams.size(); ++i) {
+				sum += discrimination * (theta - categoryparams[i]);
+				double num = exp(sum);
+				x += discrimination;
+				double num_x = num * x;
+				g += num;
+				g_prime += num_x;
+				g_primeprime += num_x * x;
+			}
+		}
+		if (g == 0.0 || std::isinf(g)) {
+			model::extreme_theta(theta);
+		}
+		double b = g * g;
+		double b2 = b * b;
+		double b_prime = 2.0 * g * g_prime;
+		double a = g * f_prime - f * g_prime;
+		f_prime = a / b;
+		double a_prime = f_primeprime * g - g_primeprime * f;
+		f_primeprime = (b * a_prime - a * b_prime) / b2;
+		f /= g;
+		return -((f_prime * f_prime / f - f_primeprime) / f);
+	}
+
+	double logLikelihood_ltm(double theta) {
+		double L = 0.0;
+		for (auto question : questionSet.applicable_rows) {
+			size_t index = (size_t) question;
+			double prob = prob_ltm(theta, index);
+			int this_answer = questionSet.answers.at(index);
+			L += (this_answer * log(prob)) + ((1 - this_answer) * log(1 - prob));
+		}
+		return L;
+	}
+
+	double logLikelihood_grm(double theta) {
+		double L = 0.0;
+		for (auto question : questionSet.applicable_rows) {
+			int answer = questionSet.answers.at((size_t) question);
+			auto probs = prob_grm_pair(theta, question, answer);
+			L += log(probs.second - probs.first);
+		}
+		return L;
+	}
+
+	double logLikelihood_gpcm(double theta) {
+		double L = 0.0;
+		for (auto question : questionSet.applicable_rows) {
+			size_t answer = questionSet.answers.at((size_t) question);
+			L += log(prob_gpcm_at(theta, (size_t) question, answer - 1));
+		}
+		return L;
+	}
+
+	double ltm_d1LL(double theta) {
+		double l_theta = 0;
+		for (auto question : questionSet.applicable_rows) {
+			const double P = prob_ltm(theta, question);
+			const double guess = questionSet.guessing.at(question);
+			const double answer = questionSet.answers.at(question);
+			const double discrimination = questionSet.discrimination.at(question);
+			l_theta += discrimination * ((P - guess) / (P * (1 - guess))) * (answer - P);
+		}
+		return l_theta;
+	}
+
+	double grm_d1LL(double theta) {
+		double l_theta = 0.0;
+		for (auto question : questionSet.applicable_rows) {
+			int answer_k = questionSet.answers.at(question);
+			double P_star2, P_star1;
+			std::tie(P_star2, P_star1) = prob_grm_pair(theta, question, answer_k);
+			double Q_star1 = 1.0 - P_star1;
+			double Q_star2 = 1 - P_star2;
+			double P = P_star1 - P_star2;
+			double w2 = P_star2 * Q_star2;
+			double w1 = P_star1 * Q_star1;
+			l_theta += (-1 * questionSet.discrimination.at(question) * ((w1 - w2) / P));
+		}
+		return l_theta;
+	}
+
+	double gpcm_d1LL(double theta) {
+		double d1l = 0.0;
+		for (auto question : questionSet.applicable_rows) {
+			d1l += gpcm_partial_d1LL(theta, question, questionSet.answers.at(question));
+		}
+		return d1l;
+	}
+
+	double grm_partial_d2LL(double theta, size_t question) {
+		size_t answer_k = (size_t) questionSet.answers.at(question);
+		double P_star1;
+		double P_star2;
+		std::tie(P_star2, P_star1) = prob_grm_pair(theta, question, answer_k);
+		double P = P_star1 - P_star2;
+		double Q_star1 = 1 - P_star1;
+		double Q_star2 = 1 - P_star2;
+		double w2 = P_star2 * Q_star2;
+		double w1 = P_star1 * Q_star1;
+		double w = w1 - w2;
+		double first_term = (-w2 * (Q_star2 - P_star2) + w1 * (Q_star1 - P_star1)) / P;
+		double second_term = std::pow(w, 2.0) / std::pow(P, 2.0);
+		return first_term - second_term;
+	}
+
+	double ltm_d2LL(double theta) {
+		double lambda_theta = 0.0;
+		for (auto question : questionSet.applicable_rows) {
+			const double P = prob_ltm(theta, (size_t) question);
+			const double guess = questionSet.guessing.at(question);
+			const double Q = 1.0 - P;
+			const double lambda_temp = (P - guess) / (1.0 - guess);
+			const double discrimination = questionSet.discrimination.at(question);
+			lambda_theta += std::pow(discrimination, 2.0) * std::pow(lambda_temp, 2.0) * (Q / P);
+		}
+		return -lambda_theta;
+	}
+
+	double grm_d2LL(double theta) {
+		double lambda_theta = 0.0;
+		for (auto question : questionSet.applicable_rows) {
+			const double question_discrimination = std::pow(questionSet.discrimination.at(question), 2.0);
+			lambda_theta += question_discrimination * grm_partial_d2LL(theta, (size_t) question);
+		}
+		return lambda_theta;
+	}
+
+	double gpcm_d2LL(double theta) {
+		double d2l = 0.0;
+		for (auto question : questionSet.applicable_rows) {
+			d2l += gpcm_partial_d2LL(theta, question, questionSet.answers.at(question));
+		}
+		return d2l;
+	}
+
+	double logLikelihood(double theta) {
+		double L = 0.0;
+		if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
+			L = logLikelihood_ltm(theta);
+		}
+		if (questionSet.model == "grm") {
+			L = logLikelihood_grm(theta);
+		}
+		if (questionSet.model == "gpcm") {
+			L = logLikelihood_gpcm(theta);
+		}
+		return L;
+	}
+
+	double d1LL(double theta) {
+		double l_theta = 0.0;
+		if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
+			l_theta = ltm_d1LL(theta);
+		}
+		if (questionSet.model == "grm") {
+			l_theta = grm_d1LL(theta);
+		}
+		if (questionSet.model == "gpcm") {
+			l_theta = gpcm_d1LL(theta);
+		}
+		return l_theta;
+	}
+
+	double d2LL(double theta) {
+		double lambda_theta = 0.0;
+		if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
+			lambda_theta = ltm_d2LL(theta);
+		}
+		if (questionSet.model == "grm") {
+			lambda_theta = grm_d2LL(theta);
+		}
+		if (questionSet.model == "gpcm") {
+			lambda_theta = gpcm_d2LL(theta);
+		}
+		return lambda_theta;
+	}
+};
+
+/**
+ * Estimator::sumAnswers and useModel, over the flattened thresholds.
+ */
+struct PolicyEstimator {
+	const Bank &questionSet;
+	double (PolicyEstimator::*logLikelihood_kernel)(double);
+	double (PolicyEstimator::*d1LL_kernel)(double);
+	double (PolicyEstimator::*d2LL_kernel)(double);
+
+	explicit PolicyEstimator(const Bank &bank) : questionSet(bank) {
+		if (bank.model == "ltm" || bank.model == "tpm") {
+			useModel<model::Binary>();
+		} else if (bank.model == "grm") {
+			useModel<model::Graded>();
+		} else {
+			useModel<model::PartialCredit>();
+		}
+	}
+
+	model::Item itemParameters(size_t question) const {
+		const size_t first = questionSet.offsets[question];
+		return model::Item{questionSet.discrimination.at(question), questionSet.guessing[question],
+		                   questionSet.values.data() + first, questionSet.offsets[question + 1] - first};
+	}
+
+	template <double (*Term)(double, const model::Item &, int)>
+	double sumAnswers(double theta) {
+		double sum = 0.0;
+		for (auto question : questionSet.applicable_rows) {
+			sum += Term(theta, itemParameters(question), questionSet.answers[question]);
+		}
+		return sum;
+	}
+
+	template <class Model>
+	void useModel() {
+		logLikelihood_kernel = &PolicyEstimator::sumAnswers<&Model::logProbability>;
+		d1LL_kernel = &PolicyEstimator::sumAnswers<&Model::d1>;
+		d2LL_kernel = &PolicyEstimator::sumAnswers<&Model::d2>;
+	}
+
+	double logLikelihood(double theta) { return (this->*logLikelihood_kernel)(theta); }
+	double d1LL(double theta) { return (this->*d1LL_kernel)(theta); }
+	double d2LL(double theta) { return (this->*d2LL_kernel)(theta); }
+};
+
+template <class Evaluate>
+static double nanoseconds_per_call(Evaluate evaluate, size_t evaluations, double &sink) {
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < evaluations; ++i) {
+		const double theta = -3.0 + 6.0 * (double) (i % 997) / 996.0;
+		sink += evaluate(theta);
+	}
+	auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start);
+	return elapsed.count() / evaluations;
+}
+
+int main(int argc, char **argv) {
+	const size_t items = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 300;
+	const size_t answered = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 40;
+	const size_t evaluations = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 200000;
+
+	std::mt19937 rng(20240601);
+	double sink = 0.0;
+	std::printf("%zu items, %zu answered, %zu evaluations; ns per evaluation\n", items, answered, evaluations);
+	std::printf("%-6s %-14s %10s %10s %8s %10s\n", "model", "function", "string", "policy", "speedup", "max diff");
+
+	const char *models[] = {"ltm", "tpm", "grm", "gpcm"};
+	for (const char *name : models) {
+		Bank bank = make_bank(name, items, answered, rng);
+		LegacyEstimator legacy{bank};
+		PolicyEstimator policy(bank);
+
+		struct Function {
+			const char *name;
+			double (LegacyEstimator::*legacy)(double);
+			double (PolicyEstimator::*policy)(double);
+		};
+		const Function functions[] = {
+			{"logLikelihood", &LegacyEstimator::logLikelihood, &PolicyEstimator::logLikelihood},
+			{"d1LL", &LegacyEstimator::d1LL, &PolicyEstimator::d1LL},
+			{"d2LL", &LegacyEstimator::d2LL, &PolicyEstimator::d2LL},
+		};
+
+		for (const Function &function : functions) {
+			double max_diff = 0.0;
+			for (double theta = -3.0; theta <= 3.0; theta += 0.05) {
+				double before = (legacy.*function.legacy)(theta);
+				double after = (policy.*function.policy)(theta);
+				max_diff = std::max(max_diff, std::abs(before - after) / std::max(1.0, std::abs(before)));
+			}
+
+			double string_ns = nanoseconds_per_call([&](double theta) { return (legacy.*function.legacy)(theta); },
+			                                        evaluations, sink);
+			double policy_ns = nanoseconds_per_call([&](double theta) { return (policy.*function.policy)(theta); },
+			                                        evaluations, sink);
+			std::printf("%-6s %-14s %10.1f %10.1f %7.2fx %10.2g\n", name, function.name, string_ns, policy_ns,
+			            string_ns / policy_ns, max_diff);
+		}
+	}
+	std::printf("(checksum %g)\n", sink);
+	return 0;
+}
@@ -1,7 +1,10 @@
 #include "Rcpp.h"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <math.h>
 #include "Cat.h"
+#include "LookAheadSearch.h"
 #include "EAPEstimator.h"
 #include "MAPEstimator.h"
 #include "MLEEstimator.h"
@@ -16,30 +19,192 @@
 #include "LKLSelector.h"
 #include "PKLSelector.h"
 #include "RANDOMSelector.h"
+#include "ParallelUtil.h"
+#include "Warnings.h"
 
 
+struct ExpectedPV : public mpl::FunctionCaller<const SelectionContext>
+{
+	using Base = mpl::FunctionCaller<const SelectionContext>;
+
+	ExpectedPV(Estimator& e, const SelectionContext& c):Base{e,c}{}
+
+	double operator()(int question)
+	{
+		return estimator.expectedPV(question, arg);
+	}
+};
+
 using namespace Rcpp;
 
-Cat::Cat(S4 cat_df) : questionSet(cat_df),
-                      integrator(Integrator()),
+Cat::Cat(S4 cat_df) : Cat(cat_df, CatOptions()) {}
+
+Cat::Cat(S4 cat_df, const CatOptions &options) : Cat(cat_df, options, std::make_shared<const ItemBank>(cat_df)) {}
+
+Cat::Cat(S4 cat_df, const CatOptions &options, std::shared_ptr<const ItemBank> bank) : questionSet(cat_df, bank),
+                      integrator(options.quadrature, options.quadraturePoints,
+                                 questionSet.lowerBound, questionSet.upperBound),
                       prior(cat_df),
                       checkRules(cat_df),
-                      estimator(createEstimator(cat_df, integrator, questionSet)),
-                      selector(createSelector(cat_df.slot("selection"), questionSet, *estimator, prior)){}
+                      gridPosterior(integrator, prior),
+                      screeningSize(options.screeningSize),
+                      lookAheadDepth(options.lookAheadDepth),
+                      lookAheadTolerance(options.lookAheadTolerance),
+                      estimation_type(Rcpp::as<std::string>(cat_df.slot("estimation"))),
+                      estimation_default(Rcpp::as<std::string>(cat_df.slot("estimationDefault"))),
+                      selection_type(Rcpp::as<std::string>(cat_df.slot("selection"))),
+                      estimator(createEstimator(estimation_type, estimation_default, integrator, questionSet)),
+                      selector(createSelector(selection_type, questionSet, *estimator, prior)){
+  if (gridPosterior.isActive()) {
+    gridPosterior.reset(questionSet, questionSet.bank->tables(integrator.getNodes(), questionSet));
+  }
+  estimator->setGridPosterior(&gridPosterior);
+  selector->setScreeningSize(screeningSize);
+
+  if (options.mfiResolution > 0.0) {
+    const double range = questionSet.upperBound - questionSet.lowerBound;
+    const double cells = std::ceil(range / options.mfiResolution);
+    if (cells > 100000) {
+      Rcpp::stop("mfiResolution is too small for the bounds of integration.");
+    }
+    mfiIndex = questionSet.bank->mfiIndex(questionSet.lowerBound, questionSet.upperBound, (size_t) cells, *estimator,
+                                          questionSet);
+    selector->setMFIIndex(mfiIndex.get());
+  }
+}
+
+void Cat::storeAnswer(int item, int answer) {
+  if (item < 0 || size_t(item) >= questionSet.answers.size()) {
+    Rcpp::stop("Must use a question number applicable to Cat object.");
+  }
+
+  if (answer != NA_INTEGER && answer != -1) {
+    bool binary = (questionSet.modelType == ModelType::LTM) | (questionSet.modelType == ModelType::TPM);
+    int min_response = binary ? 0 : 1;
+    int max_response = binary ? 1 : questionSet.bank->categories[item];
+    if (answer < min_response || answer > max_response) {
+      Rcpp::stop("%d is not a valid answer for question %d.", answer, item + 1);
+    }
+  }
+
+  const bool was_default = usesEstimationDefault();
+  const bool was_empty = questionSet.applicable_rows.empty();
+  const int old_answer = questionSet.answers.at(item);
+
+  if (old_answer == answer) {
+    return;
+  }
+  if (gridPosterior.isActive() && old_answer != NA_INTEGER && old_answer != -1) {
+    gridPosterior.removeAnswer(item, old_answer);
+  }
+  questionSet.reset_answer(item, answer);
+  if (gridPosterior.isActive() && answer != NA_INTEGER && answer != -1) {
+    gridPosterior.addAnswer(item, answer);
+  }
+
+  if (usesEstimationDefault() != was_default) {
+    resetStrategies(true);
+  } else if (questionSet.applicable_rows.empty() != was_empty) {
+    resetStrategies(false);
+  }
+}
+
+Cat::Branch::Branch(Cat &cat) : questionSet(cat.questionSet), gridPosterior(cat.gridPosterior) {
+  createStrategies(cat);
+}
+
+Cat::Branch::Branch(Cat &cat, int item, int answer) : questionSet(cat.questionSet), gridPosterior(cat.gridPosterior) {
+  store(item, answer);
+  createStrategies(cat);
+}
+
+Cat::Branch::Branch(Cat &cat, const Branch &parent, int item, int answer) : questionSet(parent.questionSet),
+                                                                             gridPosterior(parent.gridPosterior) {
+  store(item, answer);
+  createStrategies(cat);
+}
+
+void Cat::Branch::store(int item, int answer) {
+  questionSet.reset_answer(item, answer);
+  if (gridPosterior.isActive() && answer != -1) {
+    gridPosterior.addAnswer(item, answer);
+  }
+}
+
+void Cat::Branch::createStrategies(Cat &cat) {
+  estimator = createEstimator(cat.estimation_type, cat.estimation_default, cat.integrator, questionSet, false);
+  estimator->setGridPosterior(&gridPosterior);
+  selector = createSelector(cat.selection_type, questionSet, *estimator, cat.prior, false);
+  selector->setMFIIndex(cat.mfiIndex.get());
+  selector->setScreeningSize(cat.screeningSize);
+}
+
+void Cat::resetAnswers(const std::vector<int> &answers) {
+  const bool was_default = usesEstimationDefault();
+  const bool was_empty = questionSet.applicable_rows.empty();
+
+  questionSet.reset_answers(answers);
+  if (gridPosterior.isActive()) {
+    gridPosterior.reset(questionSet, questionSet.bank->tables(integrator.getNodes(), questionSet));
+  }
+
+  if (usesEstimationDefault() != was_default) {
+    resetStrategies(true);
+  } else if (questionSet.applicable_rows.empty() != was_empty) {
+    resetStrategies(false);
+  }
+}
+
+std::vector<int> Cat::getAnswers() {
+  return questionSet.answers;
+}
+
+std::shared_ptr<const ItemBank> Cat::getItemBank() const {
+  return questionSet.bank;
+}
+
+std::vector<int> Cat::responseOptions(int item) const {
+  // binary items are answered from 0, the others from 1
+  const bool binary = (questionSet.modelType == ModelType::LTM) | (questionSet.modelType == ModelType::TPM);
+  std::vector<int> options{-1};
+  for (size_t i = 1; i <= questionSet.difficulty.at(item).size()+1; ++i) {
+      options.push_back(binary ? (int) i - 1 : (int) i);
+  }
+  return options;
+}
+
+bool Cat::usesEstimationDefault() const {
+  return questionSet.applicable_rows.empty() || questionSet.all_extreme;
+}
+
+void Cat::resetStrategies(bool estimation_changed) {
+  // the selector holds a reference to the estimator, so it is always rebuilt alongside it
+  if (estimation_changed) {
+    estimator = createEstimator(estimation_type, estimation_default, integrator, questionSet);
+    estimator->setGridPosterior(&gridPosterior);
+  }
+  selector = createSelector(selection_type, questionSet, *estimator, prior);
+  selector->setMFIIndex(mfiIndex.get());
+  selector->setScreeningSize(screeningSize);
+}
 
-bool Cat::checkStopRules() { 
-  if(noneOfOverrides())
+bool Cat::checkStopRules() {
+  return checkStopRules(questionSet, *estimator);
+}
+
+bool Cat::checkStopRules(QuestionSet &questions, Estimator &estimation) {
+  if(noneOfOverrides(questions, estimation))
   {
-    return anyOfThresholds();
+    return anyOfThresholds(questions, estimation);
   }
   return false;  
 }
 
-bool Cat::anyOfThresholds()
+bool Cat::anyOfThresholds(QuestionSet &questions, Estimator &estimation)
 {  
   if (! std::isnan(checkRules.lengthThreshold)){
       //added non-response to length count
-      if((questionSet.applicable_rows.size() + questionSet.skipped.size()) >= checkRules.lengthThreshold){
+      if((questions.applicable_rows.size() + questions.skipped.size()) >= checkRules.lengthThreshold){
           return true;
       }
   }
@@ -47,17 +212,16 @@ bool Cat::anyOfThresholds()
   
   
   if (! std::isnan(checkRules.seThreshold)) {
-      double se = estimator->estimateSE(prior);
+      double se = estimation.estimateSE(prior);
     if(se < checkRules.seThreshold ) {
       return true;
     }
   }
 
   if (! std::isnan(checkRules.gainThreshold)){
-    bool answer_gainThreshold  = std::all_of(questionSet.nonapplicable_rows.begin(), questionSet.nonapplicable_rows.end(), [&](int item)
+    std::vector<double> gains = expectedGains(questions, estimation);
+    bool answer_gainThreshold  = std::all_of(gains.begin(), gains.end(), [&](double gain)
     {
-        double se = estimator->estimateSE(prior);
-        double gain = std::abs(se - std::pow(expectedPV(item), 0.5));
         return gain < checkRules.gainThreshold;
     });
 
@@ -68,10 +232,10 @@ bool Cat::anyOfThresholds()
 
 
   if (! std::isnan(checkRules.infoThreshold)){
-    double theta = estimator->estimateTheta(prior);
-    bool answer_infoThreshold  = std::all_of(questionSet.nonapplicable_rows.begin(), questionSet.nonapplicable_rows.end(), [&](int item)
+    double theta = estimation.estimateTheta(prior);
+    bool answer_infoThreshold  = std::all_of(questions.nonapplicable_rows.begin(), questions.nonapplicable_rows.end(), [&](int item)
     {
-        double info = estimator->fisherInf(theta, item);
+        double info = estimation.fisherInf(theta, item);
         return info < checkRules.infoThreshold;
     });
 
@@ -83,19 +247,18 @@ bool Cat::anyOfThresholds()
   return false;
 }
 
-bool Cat::noneOfOverrides(){
+bool Cat::noneOfOverrides(QuestionSet &questions, Estimator &estimation){
   if (! std::isnan(checkRules.lengthOverride)) {
-    if((questionSet.applicable_rows.size() + questionSet.skipped.size()) < checkRules.lengthOverride){
+    if((questions.applicable_rows.size() + questions.skipped.size()) < checkRules.lengthOverride){
       return false;
     }
   }
 
   
   if (! std::isnan(checkRules.gainOverride)){
-    bool answer_gainOverride  = std::all_of(questionSet.nonapplicable_rows.begin(), questionSet.nonapplicable_rows.end(), [&](int item)
+    std::vector<double> gains = expectedGains(questions, estimation);
+    bool answer_gainOverride  = std::all_of(gains.begin(), gains.end(), [&](double gain)
     {
-        double se = estimator->estimateSE(prior);
-        double gain = std::abs(se - std::pow(expectedPV(item), 0.5));
         return gain >= checkRules.gainOverride;
     });
 
@@ -106,6 +269,19 @@ bool Cat::noneOfOverrides(){
   return true;
 }
 
+std::vector<double> Cat::expectedGains(QuestionSet &questions, Estimator &estimation) {
+  const SelectionContext context = estimation.selectionContext(prior, SelectionContext::THETA | SelectionContext::SE);
+
+  std::vector<double> gains(questions.nonapplicable_rows.size());
+  mpl::ParallelHelper<ExpectedPV> helper(questions.nonapplicable_rows, gains, estimation, context);
+  mpl::parallelFor(0, gains.size(), helper);
+
+  for (auto &gain : gains) {
+    gain = std::abs(context.se - std::pow(gain, 0.5));
+  }
+  return gains;
+}
+
 double Cat::likelihood(double theta) {
 	return estimator->likelihood(theta);
 }
@@ -122,16 +298,49 @@ double Cat::estimateSE() {
 	return estimator->estimateSE(prior);
 }
 
+std::pair<double, double> Cat::estimateEAP() {
+	std::unique_ptr<Estimator> eap = createEstimator("EAP", estimation_default, integrator, questionSet, false);
+	eap->setGridPosterior(&gridPosterior);
+	return std::make_pair(eap->estimateTheta(prior), eap->estimateSE(prior));
+}
+
+EstimationType Cat::getEstimationType() const {
+	return estimator->getEstimationType();
+}
+
 double Cat::expectedPV(int item) {
 	return estimator->expectedPV(item, prior);
 }
 
-List Cat::selectItem() {
+List Cat::selectItem(double timeBudget) {
   if(questionSet.nonapplicable_rows.empty()){
     Rcpp::stop("selectItem should not be called if all items have been answered.");
   }
+  const bool budgeted = !std::isnan(timeBudget) && lookAheadDepth == 0;
+  if (budgeted && timeBudget < 0) {
+    Rcpp::stop("timeBudget must be non-negative.");
+  }
   
-  Selection selection = selector->selectItem();
+  Selection selection;
+  std::unique_ptr<LookAheadSearch> search;
+  if (lookAheadDepth > 0) {
+    search.reset(new LookAheadSearch(*this, lookAheadDepth, lookAheadTolerance));
+    selection = search->selectItem();
+  } else if (budgeted) {
+    const auto budget = std::chrono::duration<double, std::milli>(timeBudget);
+    selector->setDeadline(std::chrono::steady_clock::now() +
+                          std::chrono::duration_cast<std::chrono::steady_clock::duration>(budget));
+    try {
+      selection = selector->selectItem();
+    } catch (...) {
+      selector->clearDeadline();
+      throw;
+    }
+    selector->clearDeadline();
+  } else {
+    selection = selector->selectItem();
+  }
+  const int scored = (int) selection.questions.size();
     // Adding 1 to each row index so it prints the correct question number for user
     //std::transform(selection.questions.begin(), selection.questions.end(), selection.questions.begin(),
     //             bind2nd(std::plus<int>(), 1.0));
@@ -141,9 +350,74 @@ List Cat::selectItem() {
                                                    Named("q_name") = selection.question_names,
 	                                                 Named(selection.name) = selection.values);
                                                      
-	return Rcpp::List::create(Named("estimates") = all_estimates,
-                              Named("next_item") = wrap(selection.item + 1),
-	                          Named("next_item_name") = questionSet.question_names.at(selection.item));
+	List result = Rcpp::List::create(Named("estimates") = all_estimates,
+                                     Named("next_item") = wrap(selection.item + 1),
+	                                 Named("next_item_name") = questionSet.question_names.at(selection.item));
+	if (screeningSize > 0) {
+	  result["pruned"] = (int) selection.pruned;
+	}
+	if (search) {
+	  result["nodesExpanded"] = (int) search->getExpanded();
+	  result["nodesPruned"] = (int) search->getPruned();
+	}
+	if (budgeted) {
+	  result["timedOut"] = selection.timedOut;
+	  result["scored"] = scored;
+	}
+	return result;
+}
+
+/**
+ * Selects on one Branch per answer. The branches share nothing but the read-only parts of the Cat, so each is
+ * built, and selects, on its own worker.
+ */
+struct Cat::BranchSelection : public RcppParallel::Worker
+{
+	Cat &cat;
+	const int item;
+	const std::vector<int> &answers;
+	std::vector<int> &items;
+	mpl::WorkerStatus status;
+
+	BranchSelection(Cat &cat, int item, const std::vector<int> &answers, std::vector<int> &items)
+		: cat(cat)
+		, item(item)
+		, answers(answers)
+		, items(items)
+		{}
+
+	void operator()(std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end && !status.failed(); ++i) {
+			status.run([&]() {
+				Branch branch(cat, item, answers[i]);
+				items[i] = branch.selector->selectItem().item;
+			});
+		}
+	}
+};
+
+std::vector<int> Cat::selectOnBranches(int item, const std::vector<int> &answers) {
+  std::vector<int> items(answers.size());
+  BranchSelection worker(*this, item, answers, items);
+  if (selectsOnMainThread()) {
+    worker(0, answers.size());
+    worker.status.rethrow();
+  } else {
+    mpl::parallelFor(0, answers.size(), worker);
+  }
+  return items;
+}
+
+bool Cat::selectsOnMainThread() const {
+  return selection_type == "RANDOM";
+}
+
+int Cat::nextItem() {
+  if (lookAheadDepth > 0) {
+    return LookAheadSearch(*this, lookAheadDepth, lookAheadTolerance).selectItem().item;
+  }
+  return selector->selectItem().item;
 }
 
 DataFrame Cat::lookAhead(int item) {
@@ -189,51 +463,10 @@ DataFrame Cat::lookAhead(int item) {
       return all_estimates;
   }
   
-  // storage vectors
-  std::vector<int> items;
-  std::vector<int> response_options;
-  
-  
-  // say item has been skipped
-  questionSet.skipped.push_back(item);
-  
-  // take item out of unanswered questions
-  questionSet.nonapplicable_rows.erase(std::remove(questionSet.nonapplicable_rows.begin(),
-                                                   questionSet.nonapplicable_rows.end(),
-                                                   item), questionSet.nonapplicable_rows.end());
-
-  questionSet.answers.at(item) = -1;
-  Selection selection = selector->selectItem();
-
-  items.push_back(selection.item + 1);
-  response_options.push_back(questionSet.answers.at(item));
-
-  // undo that item has been skipped
-  questionSet.skipped.pop_back(); // remove item from answered q's
-
-
-  // // take item out of unanswered questions
-  // questionSet.nonapplicable_rows.erase(std::remove(questionSet.nonapplicable_rows.begin(),
-  //                                                  questionSet.nonapplicable_rows.end(),
-  //                                                  item), questionSet.nonapplicable_rows.end());
-  // say item has been answered
-  questionSet.applicable_rows.push_back(item);
-
-
-  // now possible answers
-  for (size_t i = 1; i <= questionSet.difficulty.at(item).size()+1; ++i) {
-      // if binary response options, iterate from 0, otherwise iterate from 1
-      questionSet.answers.at(item) = ((questionSet.model == "ltm") | (questionSet.model == "tpm")) ?  i - 1 : i;
-      Selection selection = selector->selectItem();
-      items.push_back(selection.item + 1);
-      response_options.push_back(questionSet.answers.at(item));
-  }
-
+  std::vector<int> response_options = responseOptions(item);
+  std::vector<int> items = selectOnBranches(item, response_options);
+  std::for_each(items.begin(), items.end(), [](int& d) { d+=1;});
 
-  questionSet.nonapplicable_rows.push_back(item); // add item back to unanswered q's
-  questionSet.applicable_rows.pop_back(); // remove item from answered q's
-  questionSet.answers.at(item) = NA_INTEGER; // remove answer
-    
   DataFrame all_estimates = Rcpp::DataFrame::create(Named("response_option") = response_options,
                                                    Named("next_item") = items);
   return all_estimates;
@@ -268,11 +501,8 @@ double Cat::fisherInf(double theta, int item) {
  * A fairly naive implementation of a factory method for Estimators. Ideally, this will be refactored
  * into a separate factory with registration.
  */
-std::unique_ptr<Estimator> Cat::createEstimator(S4 &cat_df, Integrator &integrator, QuestionSet &questionSet) {
-    
-    
-	std::string estimation_type = cat_df.slot("estimation");
-  std::string estimation_default = cat_df.slot("estimationDefault");
+std::unique_ptr<Estimator> Cat::createEstimator(std::string estimation_type, std::string estimation_default,
+                                                Integrator &integrator, QuestionSet &questionSet, bool warn) {
   
 	// Note that this comparison is only legal because std::string, which overrides ==, is being used.
 	// If, for some reason, C-style strings are ever used here, strncmp will have to be inserted.
@@ -289,7 +519,7 @@ std::unique_ptr<Estimator> Cat::createEstimator(S4 &cat_df, Integrator &integrat
 	if (estimation_type == "MLE" || estimation_type == "WLE") {
 
 	    if (questionSet.applicable_rows.size() == 0 || questionSet.all_extreme){
-	        Rcpp::Rcout<<"Warning: estimationDefault will be used to estimate theta as the maximum likelihood cannot be computed with an answer profile of all extreme response options."<<std::endl;
+	        if (warn) warnings::warn("Warning: estimationDefault will be used to estimate theta as the maximum likelihood cannot be computed with an answer profile of all extreme response options.");
 	        if (estimation_default == "MAP") return std::unique_ptr<MAPEstimator>(new MAPEstimator(integrator, questionSet));
 	        if (estimation_default == "EAP") return std::unique_ptr<EAPEstimator>(new EAPEstimator(integrator, questionSet));
 	    } 
@@ -310,7 +540,7 @@ std::unique_ptr<Estimator> Cat::createEstimator(S4 &cat_df, Integrator &integrat
  * into a separate factory with registration.
  */
 std::unique_ptr<Selector> Cat::createSelector(std::string selection_type, QuestionSet &questionSet,
-                                              Estimator &estimator, Prior &prior) {
+                                              Estimator &estimator, Prior &prior, bool warn) {
 
 	if (selection_type == "EPV") {
 		return std::unique_ptr<EPVSelector>(new EPVSelector(questionSet, estimator, prior));
@@ -349,7 +579,7 @@ std::unique_ptr<Selector> Cat::createSelector(std::string selection_type, Questi
 	// uses EPV for selection methods that fail when no questions asked
 	if (selection_type == "MFII" || selection_type == "KL") {
 	    if (questionSet.applicable_rows.size() == 0){
-	        Rcpp::Rcout<<"Warning: EPV will be used select first question since MFII and KL routines fail when no answers have been recorded."<<std::endl;
+	        if (warn) warnings::warn("Warning: EPV will be used select first question since MFII and KL routines fail when no answers have been recorded.");
 	        return std::unique_ptr<EPVSelector>(new EPVSelector(questionSet, estimator, prior));
 	    }else{
 	        if(selection_type == "MFII"){
@@ -1,11 +1,13 @@
 #pragma once
 #include <Rcpp.h>
 #include <memory>
+#include <utility>
 #include "Prior.h"
 #include "QuestionSet.h"
 #include "Estimator.h"
 #include "Selector.h"
 #include "CheckRules.h"
+#include "CatOptions.h"
 #include "MAPEstimator.h"
 using namespace Rcpp;
 
@@ -19,10 +21,49 @@ public:
 
 	Cat(S4 cat_df);
 
+	/**
+	 * Builds the Cat with engine options that have no slot on the S4 class (e.g. fixed-grid quadrature).
+	 */
+	Cat(S4 cat_df, const CatOptions &options);
+
+	/**
+	 * Builds the Cat on an existing ItemBank, so that sessions over the same items share one copy of the
+	 * parameters and of the quadrature tables.
+	 */
+	Cat(S4 cat_df, const CatOptions &options, std::shared_ptr<const ItemBank> bank);
+
+	/**
+	 * Records a single answer (NA_INTEGER to retract, -1 for a skip) against the question set. Used by
+	 * persistent sessions, which keep the Cat alive between calls and only receive the changed answer.
+	 */
+	void storeAnswer(int item, int answer);
+
+	/**
+	 * Replaces every answer at once (one per question, NA_INTEGER for unanswered), as batch scoring does for each
+	 * response row. The answers are not validated, and nothing here calls into R, so a Cat owned by one worker may
+	 * be reset on that worker's thread.
+	 */
+	void resetAnswers(const std::vector<int> &answers);
+
+	std::vector<int> getAnswers();
+
+	std::shared_ptr<const ItemBank> getItemBank() const;
+
 	double estimateTheta();
 
 	double estimateSE();
 
+	/**
+	 * Theta and its standard error estimated by EAP on the Cat's answers, whatever the Cat's own estimator, with an
+	 * estimator built for the call. simulateCat falls back to it when the final estimate fails.
+	 */
+	std::pair<double, double> estimateEAP();
+
+	/**
+	 * The type of the estimator in use, which is estimationDefault's while it stands in for MLE or WLE.
+	 */
+	EstimationType getEstimationType() const;
+
 	double likelihood(double theta);
 
 	double expectedPV(int item);
@@ -37,7 +78,19 @@ public:
 
 	double expectedObsInf(int item);
 	
-	Rcpp::List selectItem();
+	/**
+	 * timeBudget, in milliseconds, bounds the time the selector spends scoring candidates (see Selector::score);
+	 * NaN for no bound. With a bound, the result also reports whether it ran out and how many items it scored.
+	 * Lookahead selection ignores the bound.
+	 */
+	Rcpp::List selectItem(double timeBudget);
+
+	/**
+	 * The item (0-indexed) selectItem would choose, without building the R list, so that a Cat owned by one worker
+	 * may select on that worker's thread. At least one item must be unanswered, and RANDOM selection, which draws
+	 * from R's generator, must stay on the main thread.
+	 */
+	int nextItem();
 	
 	Rcpp::DataFrame lookAhead(int item);
 	
@@ -58,8 +111,21 @@ public:
 	double fisherTestInfo(double theta);
 
 private:
-	bool noneOfOverrides();
-	bool anyOfThresholds();
+	friend class CatTree;
+	friend class LookAheadSearch;
+	friend class Precomputation;
+
+	/**
+	 * The stop rules for any question set and the estimator built on it: the Cat's own, or a Branch's.
+	 */
+	bool checkStopRules(QuestionSet &questions, Estimator &estimation);
+	bool noneOfOverrides(QuestionSet &questions, Estimator &estimation);
+	bool anyOfThresholds(QuestionSet &questions, Estimator &estimation);
+
+	/**
+	 * -1 (a skip), then every answer to item: from 0 for binary items and from 1 for the others.
+	 */
+	std::vector<int> responseOptions(int item) const;
 
 
 private:
@@ -69,6 +135,36 @@ private:
 	Prior prior;
 	CheckRules checkRules;
 
+	/**
+	 * Answered items' log-likelihood on the quadrature grid (active only with a fixed quadrature rule). Every change
+	 * to questionSet.answers made through this class is mirrored here.
+	 */
+	GridPosterior gridPosterior;
+
+	/**
+	 * The bank's MFI ranking index, when the session was created with the mfiResolution option. Handed to every
+	 * selector the Cat creates.
+	 */
+	std::shared_ptr<const MFIIndex> mfiIndex;
+
+	/**
+	 * The screeningSize option, likewise handed to every selector. When it is set, selectItem also reports how many
+	 * items were screened out.
+	 */
+	size_t screeningSize;
+
+	/**
+	 * The lookAheadDepth and lookAheadTolerance options. With a depth, selectItem and nextItem choose items with a
+	 * LookAheadSearch of that depth instead of the selector, and selectItem reports the branches it expanded and
+	 * pruned.
+	 */
+	size_t lookAheadDepth;
+	double lookAheadTolerance;
+
+	std::string estimation_type;
+	std::string estimation_default;
+	std::string selection_type;
+
 
 	/**
 	 * In C++, an object of abstract type may not be used an an instance variable. This is because, by virtue of
@@ -94,10 +190,62 @@ private:
 	 * determining which subtype to instantiate, that task is harder than it should be. In the future, this would be
 	 * a good refactoring to do.
 	 */
-	static std::unique_ptr<Estimator> createEstimator(S4 &cat_df, Integrator &integrator, QuestionSet &questionSet);
+	static std::unique_ptr<Estimator> createEstimator(std::string estimation_type, std::string estimation_default,
+	                                                  Integrator &integrator, QuestionSet &questionSet,
+	                                                  bool warn = true);
 	static std::unique_ptr<Selector> createSelector(std::string selection_type, QuestionSet &questionSet,
 	                                                Estimator &estimator,
-	                                                Prior &prior);
+	                                                Prior &prior, bool warn = true);
+
+	/**
+	 * The factories above fall back to estimationDefault (MLE/WLE with no answers or only extreme answers)
+	 * and to EPV (MFII/KL with no answers). A long-lived Cat has to revisit those choices whenever an
+	 * answer changes which side of the fallback it is on.
+	 */
+	bool usesEstimationDefault() const;
+	void resetStrategies(bool estimation_changed);
+
+	/**
+	 * The Cat's answers with one hypothetical answer (or skip) stored, in a copy of the question set and grid
+	 * posterior with an estimator and selector of its own, chosen as storeAnswer would choose them but without the
+	 * fallback warnings. lookAhead selects on one branch per response option and leaves the Cat itself untouched.
+	 *
+	 * A branch may also be taken from another branch, copying the parent's grid posterior rather than rebuilding
+	 * it, which is how CatTree descends; Branch(cat) copies the Cat's answers as they are.
+	 */
+	struct Branch {
+		QuestionSet questionSet;
+		GridPosterior gridPosterior;
+		std::unique_ptr<Estimator> estimator;
+		std::unique_ptr<Selector> selector;
+
+		explicit Branch(Cat &cat);
+		Branch(Cat &cat, int item, int answer);
+		Branch(Cat &cat, const Branch &parent, int item, int answer);
+		Branch(const Branch &) = delete;
+		Branch &operator=(const Branch &) = delete;
+
+	private:
+		void store(int item, int answer);
+		void createStrategies(Cat &cat);
+	};
+
+	/**
+	 * The item (0-indexed) the selector would choose after each of answers to item, every answer on a Branch of
+	 * its own, selected in parallel.
+	 */
+	struct BranchSelection;
+	std::vector<int> selectOnBranches(int item, const std::vector<int> &answers);
+
+	/**
+	 * RANDOM selection draws from R's generator, so its branches are selected one after another on the main thread.
+	 */
+	bool selectsOnMainThread() const;
+
+	/**
+	 * |SE - sqrt(expectedPV)| for every unanswered item, for the gain stop rules, computed in parallel.
+	 */
+	std::vector<double> expectedGains(QuestionSet &questions, Estimator &estimation);
 
 
 };
@@ -0,0 +1,64 @@
+#include "CatOptions.h"
+
+CatOptions::CatOptions() : quadrature(QuadratureType::ADAPTIVE), quadraturePoints(61), mfiResolution(0.0), screeningSize(0),
+                           lookAheadDepth(0), lookAheadTolerance(0.0) { }
+
+CatOptions::CatOptions(const Rcpp::List &options) : CatOptions() {
+  if (options.size() == 0) {
+    return;
+  }
+
+  if (Rf_isNull(options.names())) {
+    Rcpp::stop("options must be a named list.");
+  }
+  Rcpp::CharacterVector names = options.names();
+  for (int i = 0; i < options.size(); ++i) {
+    std::string name = Rcpp::as<std::string>(names[i]);
+
+    if (name == "quadrature") {
+      std::string type = Rcpp::as<std::string>(options[i]);
+      try {
+        quadrature = Integrator::parseQuadratureType(type);
+      } catch (std::invalid_argument &) {
+        Rcpp::stop("%s is not a valid quadrature type.", type);
+      }
+    } else if (name == "quadraturePoints") {
+      int points = Rcpp::as<int>(options[i]);
+      if (points < 2 || points > 1000) {
+        Rcpp::stop("quadraturePoints must be between 2 and 1000.");
+      }
+      quadraturePoints = (size_t) points;
+    } else if (name == "mfiResolution") {
+      double resolution = Rcpp::as<double>(options[i]);
+      if (!(resolution > 0.0)) {
+        Rcpp::stop("mfiResolution must be positive.");
+      }
+      mfiResolution = resolution;
+    } else if (name == "screeningSize") {
+      int size = Rcpp::as<int>(options[i]);
+      if (size < 1) {
+        Rcpp::stop("screeningSize must be at least 1.");
+      }
+      screeningSize = (size_t) size;
+    } else if (name == "lookAheadDepth") {
+      int depth = Rcpp::as<int>(options[i]);
+      if (depth < 1) {
+        Rcpp::stop("lookAheadDepth must be at least 1.");
+      }
+      lookAheadDepth = (size_t) depth;
+    } else if (name == "lookAheadTolerance") {
+      double tolerance = Rcpp::as<double>(options[i]);
+      if (!(tolerance >= 0.0)) {
+        Rcpp::stop("lookAheadTolerance must be non-negative.");
+      }
+      lookAheadTolerance = tolerance;
+    } else {
+      Rcpp::stop("%s is not a valid option.", name);
+    }
+  }
+
+  // the Newton iteration for the Hermite nodes loses accuracy beyond this
+  if (quadrature == QuadratureType::HERMITE && quadraturePoints > 150) {
+    Rcpp::stop("quadraturePoints must be at most 150 for HERMITE quadrature.");
+  }
+}
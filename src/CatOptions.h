@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <Rcpp.h>
+#include "Integrator.h"
+
+/**
+ * Engine settings that are not part of the Cat S4 class, supplied as a named list when a session is created.
+ * The default-constructed options reproduce the behavior of the functions taking a Cat object.
+ */
+struct CatOptions {
+
+	QuadratureType quadrature;
+	size_t quadraturePoints;
+	/**
+	 * Width of the theta cells of the MFI ranking index; 0 scores every item instead.
+	 */
+	double mfiResolution;
+	/**
+	 * Number of unanswered items, ranked by Fisher information at theta, the expensive selectors score; 0 scores
+	 * every item.
+	 */
+	size_t screeningSize;
+	/**
+	 * Number of items the LookAheadSearch looks ahead, the candidate included; 0 selects with the selector.
+	 */
+	size_t lookAheadDepth;
+	/**
+	 * Branches whose probability mass times standard error is below this are not searched further.
+	 */
+	double lookAheadTolerance;
+
+	CatOptions();
+
+	CatOptions(const Rcpp::List &options);
+};
@@ -0,0 +1,163 @@
+#include <Rcpp.h>
+#include <RcppParallel.h>
+#include <cmath>
+#include <unordered_map>
+#include "CatTree.h"
+#include "ParallelUtil.h"
+
+namespace {
+
+/**
+ * Hashes a full answer vector, which identifies a state of the tree whatever order the answers were given in.
+ */
+struct AnswersHash {
+	size_t operator()(const std::vector<int> &answers) const {
+		size_t hash = answers.size();
+		for (int answer : answers) {
+			hash = hash * 31 + (size_t) (unsigned) answer;
+		}
+		return hash;
+	}
+};
+
+}
+
+/**
+ * A child state to expand: the parent's branch (an index into the current level) and the answer stored on it.
+ */
+struct Pending {
+	size_t parent;
+	int item;
+	int answer;
+};
+
+/**
+ * Builds the branch of each pending child, checks its stop rules, and, if it goes on, selects its item. The
+ * selectors' own loops nest inside this one.
+ */
+struct CatTree::Expansion : public RcppParallel::Worker
+{
+	CatTree &tree;
+	const std::vector<Pending> &pending;
+	const std::vector<std::unique_ptr<Cat::Branch> > &parents;
+	std::vector<std::unique_ptr<Cat::Branch> > &children;
+	std::vector<int> &items;
+	mpl::WorkerStatus status;
+
+	Expansion(CatTree &tree, const std::vector<Pending> &pending,
+	          const std::vector<std::unique_ptr<Cat::Branch> > &parents,
+	          std::vector<std::unique_ptr<Cat::Branch> > &children, std::vector<int> &items)
+		: tree(tree)
+		, pending(pending)
+		, parents(parents)
+		, children(children)
+		, items(items)
+		{}
+
+	void operator()(std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end && !status.failed(); ++i) {
+			status.run([&]() { expand(i); });
+		}
+	}
+
+	void expand(std::size_t i)
+	{
+		const Pending &child = pending[i];
+		std::unique_ptr<Cat::Branch> branch(new Cat::Branch(tree.cat, *parents[child.parent], child.item, child.answer));
+		if (tree.stops(*branch)) {
+			items[i] = -1;
+			return;
+		}
+		items[i] = branch->selector->selectItem().item;
+		children[i] = std::move(branch);
+	}
+};
+
+CatTree::CatTree(Cat &cat) : cat(cat), memoized(0) {
+	if (cat.questionSet.nonapplicable_rows.empty()) {
+		Rcpp::stop("makeTree should not be called if all items have been answered.");
+	}
+	std::vector<std::unique_ptr<Cat::Branch> > level;
+	level.emplace_back(new Cat::Branch(cat));
+	std::vector<int> levelNodes{0};
+	nodes.push_back(Node{level[0]->selector->selectItem().item, {}});
+
+	while (!level.empty()) {
+		// the children of this level, each distinct answer vector once
+		std::vector<Pending> pending;
+		std::vector<size_t> links;
+		std::unordered_map<std::vector<int>, size_t, AnswersHash> states;
+		for (size_t parent = 0; parent < level.size(); ++parent) {
+			Node &node = nodes[levelNodes[parent]];
+			const std::vector<int> options = responseOptions(node);
+			node.children.assign(options.size(), -1);
+
+			std::vector<int> answers = level[parent]->questionSet.answers;
+			for (int option : options) {
+				answers[node.item] = option;
+				auto state = states.emplace(answers, pending.size());
+				if (state.second) {
+					pending.push_back(Pending{parent, node.item, option});
+				} else {
+					++memoized;
+				}
+				links.push_back(state.first->second);
+			}
+		}
+
+		std::vector<std::unique_ptr<Cat::Branch> > children(pending.size());
+		std::vector<int> items(pending.size());
+		Expansion expansion(*this, pending, level, children, items);
+		if (cat.selectsOnMainThread()) {
+			expansion(0, pending.size());
+			expansion.status.rethrow();
+		} else {
+			mpl::parallelFor(0, pending.size(), expansion);
+		}
+
+		std::vector<int> created(pending.size(), -1);
+		std::vector<std::unique_ptr<Cat::Branch> > next;
+		std::vector<int> nextNodes;
+		for (size_t i = 0; i < pending.size(); ++i) {
+			if (items[i] >= 0) {
+				created[i] = (int) nodes.size();
+				nodes.push_back(Node{items[i], {}});
+				next.push_back(std::move(children[i]));
+				nextNodes.push_back(created[i]);
+			}
+		}
+
+		size_t link = 0;
+		for (int parent : levelNodes) {
+			for (int &child : nodes[parent].children) {
+				child = created[links[link++]];
+			}
+		}
+
+		level = std::move(next);
+		levelNodes = std::move(nextNodes);
+	}
+}
+
+const std::vector<CatTree::Node> &CatTree::getNodes() const {
+	return nodes;
+}
+
+std::vector<int> CatTree::responseOptions(const Node &node) const {
+	return cat.responseOptions(node.item);
+}
+
+size_t CatTree::getMemoized() const {
+	return memoized;
+}
+
+bool CatTree::stops(Cat::Branch &branch) {
+	const QuestionSet &questions = branch.questionSet;
+	const size_t answered = questions.applicable_rows.size() + questions.skipped.size();
+	const double lengthThreshold = cat.checkRules.lengthThreshold;
+	if (questions.nonapplicable_rows.size() <= 1 || (!std::isnan(lengthThreshold) && answered == lengthThreshold)) {
+		return true;
+	}
+	return cat.checkStopRules(branch.questionSet, *branch.estimator);
+}
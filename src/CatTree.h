@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include "Cat.h"
+
+/**
+ * The complete branching scheme of a Cat as makeTree describes it: starting from the Cat's answers, the item
+ * selectItem would ask next, then, for every response option to it (a skip first), either the administration
+ * stopping or the next node.
+ *
+ * The tree is built one level at a time. Every child of a level is a Cat::Branch copied from its parent's branch,
+ * so the parent's grid posterior is extended by one answer rather than rebuilt, and the children's stop rules and
+ * selections are computed in parallel. Answers given in a different order lead to the same state, and the same
+ * subtree: such states are expanded once and the node is shared, so the nodes form a DAG.
+ */
+class CatTree {
+public:
+	struct Node {
+		/**
+		 * The item asked at this node, 0-indexed.
+		 */
+		int item;
+		/**
+		 * One entry per response option of item, in the order of Cat::responseOptions: the index of the next node,
+		 * or -1 where the administration stops.
+		 */
+		std::vector<int> children;
+	};
+
+	explicit CatTree(Cat &cat);
+
+	/**
+	 * The nodes, the root first and every node after its parents.
+	 */
+	const std::vector<Node> &getNodes() const;
+
+	/**
+	 * The response options of each node's item, as the node's children are ordered.
+	 */
+	std::vector<int> responseOptions(const Node &node) const;
+
+	/**
+	 * Child states that were not expanded because the same answers had been reached through another order.
+	 */
+	size_t getMemoized() const;
+
+private:
+	struct Expansion;
+
+	Cat &cat;
+	std::vector<Node> nodes;
+	size_t memoized;
+
+	/**
+	 * Whether the administration stops at branch, by the conditions makeTree has always used: the Cat's stop rules,
+	 * a single item left, or exactly lengthThreshold items answered.
+	 */
+	bool stops(Cat::Branch &branch);
+};
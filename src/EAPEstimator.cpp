@@ -1,7 +1,10 @@
 #include "EAPEstimator.h"
-#include "GSLFunctionWrapper.h"
+#include <cmath>
 
 double EAPEstimator::estimateTheta(Prior prior) {
+	if (!integrator.isAdaptive()) {
+		return posteriorMoments(prior).theta;
+	}
 
 	/**
 	 * Because these denominator and numerator functions
@@ -9,15 +12,22 @@ double EAPEstimator::estimateTheta(Prior prior) {
 	 * the smallest scope possible. As a result, they are
 	 * declared as lambdas. They capture by reference because
 	 * they need access to prior and likelihood, but, because
-	 * they are passed to GSL's integration function, cannot
-	 * take prior and likelihood as arguments.
+	 * they are passed to the integrator, cannot
+	 * take prior and likelihood as arguments. Each call
+	 * fills in the integrand at every node of a subinterval.
 	 */
-	integrableFunction numerator = [&](double theta) {
-	  return theta * likelihood(theta) * prior.prior(theta);
+	auto numerator = [&](const double *theta, size_t n, double *out) {
+		likelihood(theta, n, out);
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = theta[i] * out[i] * prior.prior(theta[i]);
+		}
 	};
 	
-	integrableFunction denominator = [&](double theta) {
-		return likelihood(theta) * prior.prior(theta);
+	auto denominator = [&](const double *theta, size_t n, double *out) {
+		likelihood(theta, n, out);
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = out[i] * prior.prior(theta[i]);
+		}
 	};
 
 
@@ -26,67 +36,101 @@ double EAPEstimator::estimateTheta(Prior prior) {
 }
 
 double EAPEstimator::estimateTheta(Prior prior, size_t question, int answer){
-	integrableFunction numerator = [&](double theta) {
-	  return theta * likelihood(theta,question,answer) * prior.prior(theta);
+	if (!integrator.isAdaptive()) {
+		return posteriorMoments(prior, question, answer).theta;
+	}
+	auto numerator = [&](const double *theta, size_t n, double *out) {
+		likelihood(theta, n, question, answer, out);
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = theta[i] * out[i] * prior.prior(theta[i]);
+		}
 	};
 	
-	integrableFunction denominator = [&](double theta) {
-		return likelihood(theta,question,answer) * prior.prior(theta);
+	auto denominator = [&](const double *theta, size_t n, double *out) {
+		likelihood(theta, n, question, answer, out);
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = out[i] * prior.prior(theta[i]);
+		}
 	};
 	
 	return integralQuotient(numerator, denominator, questionSet.lowerBound, questionSet.upperBound);
 }
 
 double EAPEstimator::estimateSE(Prior prior) {
+	if (!integrator.isAdaptive()) {
+		return posteriorMoments(prior).se;
+	}
 	const double theta_hat = estimateTheta(prior);
 
-	integrableFunction denominator = [&](double theta) {
-		return likelihood(theta) * prior.prior(theta);
+	auto denominator = [&](const double *theta, size_t n, double *out) {
+		likelihood(theta, n, out);
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = out[i] * prior.prior(theta[i]);
+		}
 	};
 
-	integrableFunction numerator = [&](double theta) {
-		const double theta_difference = theta - theta_hat;
-		return theta_difference * theta_difference * denominator(theta);
+	auto numerator = [&](const double *theta, size_t n, double *out) {
+		denominator(theta, n, out);
+		for (size_t i = 0; i < n; ++i) {
+			const double theta_difference = theta[i] - theta_hat;
+			out[i] = theta_difference * theta_difference * out[i];
+		}
 	};
 
 	return std::pow(integralQuotient(numerator, denominator, questionSet.lowerBound, questionSet.upperBound), 0.5);
 }
 
 double EAPEstimator::estimateSE(Prior prior, size_t question, int answer) {
+	if (!integrator.isAdaptive()) {
+		return posteriorMoments(prior, question, answer).se;
+	}
 	const double theta_hat = estimateTheta(prior,question,answer);
 
-	integrableFunction denominator = [&](double theta) {
-		return likelihood(theta,question,answer) * prior.prior(theta);
+	auto denominator = [&](const double *theta, size_t n, double *out) {
+		likelihood(theta, n, question, answer, out);
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = out[i] * prior.prior(theta[i]);
+		}
 	};
 
-	integrableFunction numerator = [&](double theta) {
-		const double theta_difference = theta - theta_hat;
-		return theta_difference * theta_difference * denominator(theta);
+	auto numerator = [&](const double *theta, size_t n, double *out) {
+		denominator(theta, n, out);
+		for (size_t i = 0; i < n; ++i) {
+			const double theta_difference = theta[i] - theta_hat;
+			out[i] = theta_difference * theta_difference * out[i];
+		}
 	};
 
 	return std::pow(integralQuotient(numerator, denominator, questionSet.lowerBound, questionSet.upperBound), 0.5);
 }
 
-double EAPEstimator::integralQuotient(integrableFunction const &numerator,
-                                   integrableFunction const &denominator,
-                                   const double lower, const double upper) {
-	/*
-	 * Because GSL is a C library, not a C++ library, it is not easy to pass arbitrary
-	 * C++ functions to GSL's integration routine. To solve this, wrap the arbitrary functions
-	 * in a GSLFunctionWrapper, which is integrable.
-	 */
-	auto gslnum = GSLFunctionWrapper(numerator);
-  gsl_function *numeratorFunction = gslnum.asGSLFunction();
-  const double top = integrator.integrate(numeratorFunction, integrationSubintervals, lower, upper);
-  
-  auto gsldenom = GSLFunctionWrapper(denominator);
-  gsl_function *denominatorFunction = gsldenom.asGSLFunction();
-  const double bottom = integrator.integrate(denominatorFunction, integrationSubintervals, lower, upper);
-  
-  return top / bottom;
-}
 
 
+PosteriorMoments EAPEstimator::posteriorMoments(Prior &prior) {
+	if (gridPosterior) {
+		return gridPosterior->moments();
+	}
+
+	const std::vector<double> &nodes = integrator.getNodes();
+	std::vector<double> log_density(nodes.size());
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		log_density[i] = logLikelihood(nodes[i]) + std::log(prior.prior(nodes[i]));
+	}
+	return integrator.moments(log_density);
+}
+
+PosteriorMoments EAPEstimator::posteriorMoments(Prior &prior, size_t question, int answer) {
+	if (gridPosterior) {
+		return gridPosterior->moments(question, answer);
+	}
+
+	const std::vector<double> &nodes = integrator.getNodes();
+	std::vector<double> log_density(nodes.size());
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		log_density[i] = logLikelihood(nodes[i], question, answer) + std::log(prior.prior(nodes[i]));
+	}
+	return integrator.moments(log_density);
+}
 
 EstimationType EAPEstimator::getEstimationType() const {
 	return EstimationType::EAP;
@@ -18,17 +18,27 @@ public:
 	
 	virtual double estimateSE(Prior prior) override;
 	virtual double estimateSE(Prior prior, size_t question, int answer) override;
+
+	/**
+	 * Posterior mean, standard deviation, and normalizing constant from one pass over the fixed quadrature
+	 * nodes. Only meaningful when the integrator is not adaptive.
+	 */
+	PosteriorMoments posteriorMoments(Prior &prior);
+	PosteriorMoments posteriorMoments(Prior &prior, size_t question, int answer);
 	
 protected:
-	typedef std::function<double(double)> integrableFunction;
-
 	/**
 	* Computes the quotient of the integrals of the functions provided
 	* - that is, it computes: ∫(numerator) / ∫(denominator).
+	* Both are batch integrands, as taken by Integrator::integrateBatch.
 	*/
-	double integralQuotient(const integrableFunction &numerator,
-	                        const integrableFunction &denominator,
-                          const double lower, const double upper);
+	template <class Numerator, class Denominator>
+	double integralQuotient(const Numerator &numerator, const Denominator &denominator,
+	                        const double lower, const double upper) {
+		const double top = integrator.integrateBatch(numerator, integrationSubintervals, lower, upper);
+		const double bottom = integrator.integrateBatch(denominator, integrationSubintervals, lower, upper);
+		return top / bottom;
+	}
 	
 private:
 	/**
@@ -1,11 +1,11 @@
 #include "EPVSelector.h"
 #include "ParallelUtil.h"
 
-struct EPV_ltm_tpm : public mpl::FunctionCaller<Prior>
+struct EPV_ltm_tpm : public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<Prior>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	EPV_ltm_tpm(Estimator& e, Prior& p):Base{e,p}{}
+	EPV_ltm_tpm(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
@@ -13,11 +13,11 @@ struct EPV_ltm_tpm : public mpl::FunctionCaller<Prior>
 	}
 };
 
-struct EPV_grm: public mpl::FunctionCaller<Prior>
+struct EPV_grm: public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<Prior>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	EPV_grm(Estimator& e, Prior& p):Base{e,p}{}
+	EPV_grm(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
@@ -25,11 +25,11 @@ struct EPV_grm: public mpl::FunctionCaller<Prior>
 	}
 };
 
-struct EPV_gpcm: public mpl::FunctionCaller<Prior>
+struct EPV_gpcm: public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<Prior>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	EPV_gpcm(Estimator& e, Prior& p):Base{e,p}{}
+	EPV_gpcm(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
@@ -37,6 +37,53 @@ struct EPV_gpcm: public mpl::FunctionCaller<Prior>
 	}
 };
 
+/**
+ * EPV read off the session's grid posterior. With EAP estimation the standard error after a hypothetical answer
+ * is the standard deviation of the posterior on the grid, and that posterior is the current one times a column
+ * of the item's probability table, so each candidate costs categories x nodes multiply-adds instead of one
+ * estimateSE per category.
+ */
+struct GridEPV : public RcppParallel::Worker
+{
+	const std::vector<int>& input;
+	std::vector<double>& output;
+	Estimator& estimator;
+	const SelectionContext& context;
+	const std::vector<double>& mass;
+	const ModelType modelType;
+	mpl::WorkerStatus status;
+
+	GridEPV(const std::vector<int>& input, std::vector<double>& output, Estimator& e, const SelectionContext& c,
+	        const std::vector<double>& m, ModelType model)
+		: input(input)
+		, output(output)
+		, estimator(e)
+		, context(c)
+		, mass(m)
+		, modelType(model)
+		{}
+
+	void operator()(std::size_t begin, std::size_t end)
+	{
+		if (status.failed()) {
+			return;
+		}
+		status.run([&]() {
+			for (std::size_t i = begin; i < end; ++i) {
+				const int question = input[i];
+				auto weights = ItemTables::categoryProbabilities(estimator.probability(context.theta, question), modelType);
+				auto variances = context.posterior->answerVariances(question, mass);
+
+				double sum = 0.0;
+				for (size_t c = 0; c < variances.size(); ++c) {
+					sum += weights[c] * variances[c];
+				}
+				output[i] = sum;
+			}
+		});
+	}
+};
+
 using namespace std;
 
 Selection EPVSelector::selectItem() {
@@ -44,8 +91,11 @@ Selection EPVSelector::selectItem() {
 	// For every unanswered item, calculate the epv of that item
 	Selection selection = Selection();
 	selection.name = getSelectionName();
-	selection.questions = questionSet.nonapplicable_rows;
 
+	const SelectionContext context = estimator.selectionContext(prior, SelectionContext::THETA);
+	selection.questions = candidates(context.theta, selection);
+
+	prioritize(context, selection);
 	selection.values.resize(selection.questions.size());
 
 	/**
@@ -61,20 +111,26 @@ Selection EPVSelector::selectItem() {
 	}
 	**/
 
-	if((questionSet.model == "ltm") || (questionSet.model == "tpm"))
+	if (context.posterior && estimator.getEstimationType() == EstimationType::EAP)
+	{
+		const std::vector<double> mass = context.posterior->posteriorMass();
+		GridEPV helper(selection.questions, selection.values, estimator, context, mass, questionSet.modelType);
+		score(selection, helper);
+	}
+	else if((questionSet.modelType == ModelType::LTM) || (questionSet.modelType == ModelType::TPM))
 	{
-		mpl::ParallelHelper<EPV_ltm_tpm> helper(selection.questions, selection.values, estimator, prior);
-  		RcppParallel::parallelFor(0, selection.questions.size(), helper);
+		mpl::ParallelHelper<EPV_ltm_tpm> helper(selection.questions, selection.values, estimator, context);
+  		score(selection, helper);
 	}
-	else if (questionSet.model == "grm")
+	else if (questionSet.modelType == ModelType::GRM)
 	{
-		mpl::ParallelHelper<EPV_grm> helper(selection.questions, selection.values, estimator, prior);
-  		RcppParallel::parallelFor(0, selection.questions.size(), helper);
+		mpl::ParallelHelper<EPV_grm> helper(selection.questions, selection.values, estimator, context);
+  		score(selection, helper);
 	}
 	else
 	{
-		mpl::ParallelHelper<EPV_gpcm> helper(selection.questions, selection.values, estimator, prior);
-  		RcppParallel::parallelFor(0, selection.questions.size(), helper);
+		mpl::ParallelHelper<EPV_gpcm> helper(selection.questions, selection.values, estimator, context);
+  		score(selection, helper);
 	}
 
 	
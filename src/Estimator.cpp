@@ -6,92 +6,38 @@
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_roots.h>
 #include <gsl/gsl_errno.h>
+#include "ProbabilityKernels.h"
 
-  
-double Estimator::prob_ltm(double theta, size_t question) {
-    if(theta > 20.0 || theta < -20.0){
-        std::string msg = "Theta value " + std::to_string(theta) + " too extreme for numerical routines to provide reliable calculations.  Try using less extreme values for theta.  If using MAP estimation, try EAP instead.";
-        Rcpp::stop(msg);
-        //throw std::domain_error(msg);
-    }
-    
-	double eps = std::pow(std::pow(2.0, -52.0), 1.0/3.0);
-
-	double difficulty = questionSet.difficulty.at(question).at(0);
-	double exp_prob_bi = exp(difficulty + (questionSet.discrimination.at(question) * theta));
 
-	if(std::isinf(exp_prob_bi))
-	{
-		return 1.0 - eps;
-	}
-
-	double guess = questionSet.guessing.at(question);
-    double result = guess + (1 - guess) * (exp_prob_bi / (1 + exp_prob_bi));
-  
-  	if(result > (1.0 - eps))
-  	{
-	  result = 1.0 - eps;
-	}
-	else if(result < eps)
-	{
-	  result = eps;
-	}
-
-	return result;
+void model::extreme_theta(double theta) {
+	std::string msg = "Theta value " + std::to_string(theta) + " too extreme for numerical routines to provide reliable calculations.  Try using less extreme values for theta.  If using MAP estimation, try EAP instead.";
+	throw NumericalError(msg);
 }
 
-struct GrmProb
-{
-	GrmProb(double theta, double discrimination)
-	: theta_desc(theta*discrimination)
-	{}
-
-	double operator()(double difficulty) const
-	{
-		double exp_prob = exp(difficulty - theta_desc);
-
-		if(std::isinf(exp_prob))
-		{
-		 	return 1.0 - eps;
-		}
-
-		double result = exp_prob / (1 + exp_prob);
-		
-		if(result > (1.0 - eps))
-		{
-		  	result = 1.0 - eps;
-		}
-		else if(result < eps)
-		{
-		  	result = eps;
-		}
-		return result;
-	}
+model::Item Estimator::itemParameters(size_t question) const {
+	const double discrimination = questionSet.discrimination.at(question);
+	const ThresholdSpan thresholds = questionSet.difficulty[question];
+	return model::Item{discrimination, questionSet.guessing[question], thresholds.begin(), thresholds.size()};
+}
 
-private:
-	double eps = std::pow(std::pow(2.0, -52.0), 1.0/3.0);
-	double theta_desc;
-};
+double Estimator::prob_ltm(double theta, size_t question) {
+	return model::Binary::probability(theta, itemParameters(question));
+}
 
 std::vector<double> Estimator::prob_grm(double theta, size_t question) {
-	GrmProb calculate{theta, questionSet.discrimination.at(question)};
+	const ThresholdSpan difficulties = questionSet.difficulty.at(question);
 
-	std::vector<double> probabilities;
-	probabilities.reserve(questionSet.difficulty.size()+2);
-	probabilities.push_back(0.0);
-
-	for (auto term : questionSet.difficulty.at(question)) {
-		probabilities.push_back(calculate(term));
-	}
-
-	probabilities.push_back(1.0);
+	std::vector<double> probabilities(difficulties.size()+2);
+	probabilities.front() = 0.0;
+	kernels::grm_boundaries(theta, questionSet.discrimination.at(question), difficulties.begin(), difficulties.size(),
+	                        &probabilities[1]);
+	probabilities.back() = 1.0;
 
 	// checking for repeated elements
   	auto it = std::adjacent_find(probabilities.begin(), probabilities.end());
   	if(it != probabilities.end()){
   	    std::string msg = "Theta value " + std::to_string(theta) + " too extreme for numerical routines to provide reliable calculations.  Try using less extreme values for theta.  If using MAP estimation, try EAP instead.";
-  	    Rcpp::stop(msg);
-  	    //throw std::domain_error(msg);
+  	    throw model::NumericalError(msg);
   	}
 
 	return probabilities;
@@ -100,38 +46,7 @@ std::vector<double> Estimator::prob_grm(double theta, size_t question) {
 std::pair<double,double> Estimator::prob_grm_pair(double theta, size_t question, size_t at)
 {
 	// Returns prob at at-1 and at
-	GrmProb calculate{theta, questionSet.discrimination.at(question)};
-	std::pair<double, double> probs;
-
-	auto const& difficulties = questionSet.difficulty.at(question);
-
-	if(at == 1)
-	{
-		probs.first = 0.0;
-	}
-	else
-	{
-		probs.first = calculate(difficulties[at-2]);
-	}
-
-	if(at == difficulties.size()+1)
-	{
-		probs.second = 1.0;
-	}
-	else
-	{
-		probs.second = calculate(difficulties[at-1]);
-	}
-
-	// checking for repeated elements
-  	if(probs.first == probs.second)
-  	{
-  	    std::string msg = "Theta value " + std::to_string(theta) + " too extreme for numerical routines to provide reliable calculations.  Try using less extreme values for theta.  If using MAP estimation, try EAP instead.";
-  	    Rcpp::stop(msg);
-  	    //throw std::domain_error(msg);
-  	      	}
-
-	return probs;
+	return model::Graded::boundaries(theta, itemParameters(question), at);
 }
 
 std::vector<double> Estimator::prob_gpcm(double theta, size_t question) {
@@ -140,7 +55,7 @@ std::vector<double> Estimator::prob_gpcm(double theta, size_t question) {
   	// eps = pow(eps, 1.0/3.0);
     
   	double discrimination = questionSet.discrimination.at(question);
-  	auto const & categoryparams = questionSet.difficulty.at(question);
+  	const ThresholdSpan categoryparams = questionSet.difficulty.at(question);
  
   	std::vector<double> probabilities;
   	probabilities.reserve(categoryparams.size()+1); 	
@@ -158,8 +73,7 @@ std::vector<double> Estimator::prob_gpcm(double theta, size_t question) {
 	
 	if(denominator == 0.0 or std::isinf(denominator)){
 	    std::string msg = "Theta value " + std::to_string(theta) + " too extreme for numerical routines to provide reliable calculations.  Try using less extreme values for theta.  If using MAP estimation, try EAP instead.";
-	    Rcpp::stop(msg);
-	    //throw std::domain_error(msg);
+	    throw model::NumericalError(msg);
   	}
 
   	// normalize
@@ -173,211 +87,17 @@ std::vector<double> Estimator::prob_gpcm(double theta, size_t question) {
 
 double Estimator::prob_gpcm_at(double theta, size_t question, size_t at)
 {
-	double discrimination = questionSet.discrimination.at(question);
-  	auto const & categoryparams = questionSet.difficulty.at(question);
-
-  	double sum = discrimination * theta;
-  	double denominator = exp(sum);
-
-  	double result = -1;
-  	if(at == 0)
-  	{
-  		result = denominator;
-
-  		for (auto cat : categoryparams)
-  		{
-		  	sum += discrimination * (theta - cat);
-		  	denominator += exp(sum);
-		}
-	}
-	else
-	{
-		at -= 1;
-		for (size_t i = 0; i != at; ++i)
-  		{
-  			sum += discrimination * (theta - categoryparams[i]);
-		  	denominator += exp(sum);
-  		}
-
-  		sum += discrimination * (theta - categoryparams[at]);
-  		result = exp(sum);
-		denominator += result;
-
-		for (size_t i = at+1; i < categoryparams.size(); ++i)
-  		{
-  			sum += discrimination * (theta - categoryparams[i]);
-		  	denominator += exp(sum);
-  		}
-	}
-	
-	if(denominator == 0.0 or std::isinf(denominator)){
-	    std::string msg = "Theta value " + std::to_string(theta) + " too extreme for numerical routines to provide reliable calculations.  Try using less extreme values for theta.  If using MAP estimation, try EAP instead.";
-	    Rcpp::stop(msg);
-	    //throw std::domain_error(msg);
-  	}
-
-  	// normalize 
-	return result/denominator;
-}
-
-double Estimator::gpcm_partial_d1LL(double theta, size_t question, int answer) {
-	size_t index = ((size_t)answer) - 1;
-
-	double discrimination = questionSet.discrimination.at(question);
-  	auto const & categoryparams = questionSet.difficulty.at(question);
- 
-	double f = -1;
-	double f_prime = -1;
-	double sum = discrimination * (theta - 0.0);
-  	double g = exp(sum);
-  	double x = discrimination;
-  	double g_prime = g*x;
-
-  	if(index == 0)
-  	{
-  		f = g;
-  		f_prime = g_prime;
-
-  		for (auto cat : categoryparams)
-  		{
-		  	sum += discrimination * (theta - cat);
-	  		double num = exp(sum);
-	  		x += discrimination;
-	  		g += num;
-	  		g_prime += num*x;
-		}
-	}
-	else
-	{
-		index -= 1;
-		for (size_t i = 0; i != index; ++i)
-  		{
-  			sum += discrimination * (theta - categoryparams[i]);
-  			double num = exp(sum);
-	  		x += discrimination;
-	  		g += num;
-	  		g_prime += num*x;
-  		}
-
-  		sum += discrimination * (theta - categoryparams[index]);
-  		f = exp(sum);
-  		x += discrimination;
-	  	f_prime = f*x;
-	  	g += f;
-	  	g_prime += f_prime;
-
-		for (size_t i = index+1; i < categoryparams.size(); ++i)
-  		{
-  			sum += discrimination * (theta - categoryparams[i]);
-		  	double num = exp(sum);
-	  		x += discrimination;
-	  		g += num;
-	  		g_prime += num*x;
-  		}
-	}
-
-	if(g == 0.0 or std::isinf(g)){
-	    std::string msg = "Theta value " + std::to_string(theta) + " too extreme for numerical routines to provide reliable calculations.  Try using less extreme values for theta.  If using MAP estimation, try EAP instead.";
-	    Rcpp::stop(msg);
-	    //throw std::domain_error(msg);
-  	}
-
-  	return (g*f_prime - f*g_prime)/(g*f);
+	return model::PartialCredit::probability(theta, itemParameters(question), at);
 }
 
 double Estimator::gpcm_partial_d2LL(double theta, size_t question, int answer) {
-	size_t index = ((size_t)answer) - 1;
-
-	double discrimination = questionSet.discrimination.at(question);
-  	auto const & categoryparams = questionSet.difficulty.at(question);
- 
-	double f = -1;
-	double f_prime = -1;
-	double f_primeprime = -1;
-	double sum = discrimination * (theta - 0.0);
-  	double g = exp(sum);
-  	double x = discrimination;
-  	double g_prime = g*x;
-  	double g_primeprime = g_prime*x;
-
-
-  	if(index == 0)
-  	{
-  		f = g;
-  		f_prime = g_prime;
-  		f_primeprime = g_primeprime;
-
-  		for (auto cat : categoryparams)
-  		{
-		  	sum += discrimination * (theta - cat);
-	  		double num = exp(sum);
-	  		x += discrimination;
-	  		double num_x = num*x;
-	  		g += num;
-	  		g_prime += num_x;
-	  		g_primeprime += num_x*x;
-		}
-	}
-	else
-	{
-		index -= 1;
-		for (size_t i = 0; i != index; ++i)
-  		{
-  			sum += discrimination * (theta - categoryparams[i]);
-  			double num = exp(sum);
-	  		x += discrimination;
-	  		double num_x = num*x;
-	  		g += num;
-	  		g_prime += num_x;
-	  		g_primeprime += num_x*x;
-  		}
-
-  		sum += discrimination * (theta - categoryparams[index]);
-  		f = exp(sum);
-  		x += discrimination;
-	  	f_prime = f*x;
-	  	f_primeprime = f_prime*x;
-	  	g += f;
-	  	g_prime += f_prime;
-	  	g_primeprime += f_primeprime;
-
-		for (size_t i = index+1; i < categoryparams.size(); ++i)
-  		{
-  			sum += discrimination * (theta - categoryparams[i]);
-		  	double num = exp(sum);
-	  		x += discrimination;
-	  		double num_x = num*x;
-	  		g += num;
-	  		g_prime += num_x;
-	  		g_primeprime += num_x*x;
-  		}
-	}
-
-	if(g == 0.0 or std::isinf(g)){
-	    std::string msg = "Theta value " + std::to_string(theta) + " too extreme for numerical routines to provide reliable calculations.  Try using less extreme values for theta.  If using MAP estimation, try EAP instead.";
-	    Rcpp::stop(msg);
-	    //throw std::domain_error(msg);
-  	}
-
-	double b = g*g;
-	double b2 = b*b;
-	double b_prime = 2.0 * g * g_prime;
-    		
-	double a = g * f_prime - f * g_prime;
-	f_prime = a / b; // p_prime
-
-	double a_prime = f_primeprime * g - g_primeprime * f;
-	f_primeprime = (b * a_prime - a * b_prime) / b2; // p_primeprime
-
-	f /= g; // p
-	
-  	return - ((f_prime*f_prime/f - f_primeprime) / f);
+	return model::PartialCredit::d2(theta, itemParameters(question), answer);
 }
 
 std::vector<double> Estimator::prob_derivs_gpcm_first(double theta, size_t question)
 {
 	double discrimination = questionSet.discrimination.at(question);
-  	auto const & categoryparams = questionSet.difficulty.at(question);
+  	const ThresholdSpan categoryparams = questionSet.difficulty.at(question);
  
   	std::vector<double> f;
   	std::vector<double> f_prime;
@@ -415,7 +135,7 @@ std::vector<double> Estimator::prob_derivs_gpcm_first(double theta, size_t quest
 
 void Estimator::prob_derivs_gpcm(double theta, size_t question, std::vector<double>& probs, std::vector<double>& first, std::vector<double>& second){
   	double discrimination = questionSet.discrimination.at(question);
-  	auto const & categoryparams = questionSet.difficulty.at(question);
+  	const ThresholdSpan categoryparams = questionSet.difficulty.at(question);
  
   	probs.clear();
   	probs.reserve(categoryparams.size()+1);
@@ -468,19 +188,18 @@ void Estimator::prob_derivs_gpcm(double theta, size_t question, std::vector<doub
 
 std::vector<double> Estimator::probability(double theta, size_t question) {
   if (question > questionSet.answers.size() ) {
-      Rcpp::stop("Must use a question number applicable to Cat object.");
-    //throw std::domain_error("Must use a question number applicable to Cat object.");
+      throw std::out_of_range("Must use a question number applicable to Cat object.");
   }
   
   	std::vector<double> probabilities;
 
-	if(questionSet.model == "grm") {
+	if(questionSet.modelType == ModelType::GRM) {
 	  	probabilities = prob_grm(theta, question);
 	}
-	else if (questionSet.model == "gpcm"){
+	else if (questionSet.modelType == ModelType::GPCM){
 		probabilities = prob_gpcm(theta, question);
 	}
-	else if (questionSet.model == "ltm" || questionSet.model == "tpm")
+	else if (questionSet.modelType == ModelType::LTM || questionSet.modelType == ModelType::TPM)
 	{
 		probabilities.reserve(1);
 		probabilities.push_back(prob_ltm(theta, question));
@@ -491,384 +210,128 @@ std::vector<double> Estimator::probability(double theta, size_t question) {
 
 
 
-double Estimator::likelihood_grm(double theta) {
-	double L = 0.0;
-
+template <double (*Term)(double, const model::Item &, int)>
+double Estimator::sumAnswers(double theta) {
+	double sum = 0.0;
 	for (auto question : questionSet.applicable_rows) {
-		size_t unanswered_question = (size_t) question;
-	  	int answer = questionSet.answers.at(unanswered_question);
-		auto probs = prob_grm_pair(theta, question, answer);
-		L += log(probs.second- probs.first) ;
+		sum += Term(theta, itemParameters(question), questionSet.answers[question]);
 	}
-	return exp(L);
+	return sum;
 }
 
-double Estimator::likelihood_gpcm(double theta) {
-	double L = 0.0;
-
-	for (auto question : questionSet.applicable_rows) {
-		size_t unanswered_question = (size_t) question;
-	  	size_t answer = questionSet.answers.at(unanswered_question);
-    	// index probabilities correctly using the answer
-    	L += log(prob_gpcm_at(theta, unanswered_question, answer-1));
-	}
-	return exp(L);
+template <double (*Term)(double, const model::Item &, int)>
+double Estimator::sumAnswers(double theta, size_t question, int answer) {
+	return sumAnswers<Term>(theta) + Term(theta, itemParameters(question), answer);
 }
 
-double Estimator::likelihood_ltm(double theta) {
-	double L = 0.0;
+template <class Model>
+void Estimator::sumLogProbabilities(const double *theta, size_t n, double *out) {
+	std::fill(out, out + n, 0.0);
 	for (auto question : questionSet.applicable_rows) {
-		size_t index = (size_t) question;
-		double prob = prob_ltm(theta, index);
-		int this_answer = questionSet.answers.at(index);
-		L += (this_answer * log(prob)) + ((1 - this_answer) * log(1 - prob));
-	}
-	return exp(L);
-}
-
-double Estimator::likelihood(double theta) {
-  double likelihood = 0.0;
-
-  if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
-	  likelihood = likelihood_ltm(theta);
-	}
-	if (questionSet.model == "grm") {
-	  likelihood = likelihood_grm(theta);
-	}
-	if (questionSet.model == "gpcm"){
-		likelihood = likelihood_gpcm(theta);
-	}
-	
-	return likelihood;
-}
-
-
-double Estimator::likelihood_grm(double theta, size_t question, int answer) {
-	double L = 0.0;
-
-	for (auto q : questionSet.applicable_rows) {
-	  	size_t a = (size_t)questionSet.answers.at((size_t) q);
-    	auto probs = prob_grm_pair(theta, q, a);
-		L += log(probs.second - probs.first) ;
+		Model::addLogProbabilities(theta, n, itemParameters(question), questionSet.answers[question], out);
 	}
-
-    auto probs = prob_grm_pair(theta, question, answer);
-	L += log(probs.second - probs.first) ;
-
-	return exp(L);
-}
-
-double Estimator::likelihood_gpcm(double theta,size_t question, int answer) {
-	double L = 0.0;
-
-	for (auto q : questionSet.applicable_rows) {
-		size_t unanswered_question = (size_t) q;
-	  	auto a = (size_t)questionSet.answers.at(unanswered_question);
-    	L += log(prob_gpcm_at(theta, unanswered_question, a-1));
-	}
-
-    L += log(prob_gpcm_at(theta, question, ((size_t)answer)-1));
-
-	return exp(L);
-}
-
-double Estimator::likelihood_ltm(double theta,size_t question, int answer) {
-	double L = 0.0;
-	for (auto q : questionSet.applicable_rows) {
-		size_t index = (size_t) q;
-		double prob = prob_ltm(theta, index);
-		int this_answer = questionSet.answers.at(index);
-		L += (this_answer * log(prob)) + ((1 - this_answer) * log(1 - prob));
-	}
-
-	double prob = prob_ltm(theta, question);
-	L += (answer * log(prob)) + ((1 - answer) * log(1 - prob));
-
-	return exp(L);
-}
-
-double Estimator::likelihood(double theta, size_t question, int answer){
-	 double likelihood = 0.0;
-
-  if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
-	  likelihood = likelihood_ltm(theta,question,answer);
-	}
-	if (questionSet.model == "grm") {
-	  likelihood = likelihood_grm(theta,question,answer);
-	}
-	if (questionSet.model == "gpcm"){
-		likelihood = likelihood_gpcm(theta,question,answer);
-	}
-	
-	return likelihood;
 }
 
-double Estimator::grm_partial_d2LL(double theta, size_t question) {
-	size_t answer_k = (size_t) questionSet.answers.at(question);
-
-	double P_star1;
-	double P_star2;
-
-	std::tie(P_star2, P_star1) = prob_grm_pair(theta, question, answer_k);
-
-	double P = P_star1 - P_star2;
-
-	double Q_star1 = 1 - P_star1;
-	double Q_star2 = 1 - P_star2;
-
-	double w2 = P_star2 * Q_star2;
-	double w1 = P_star1 * Q_star1;
-	double w = w1 - w2;
-
-	double first_term = (-w2 * (Q_star2 - P_star2) + w1 * (Q_star1 - P_star1)) / P;
-	double second_term = std::pow(w, 2.0) / std::pow(P, 2.0);
-	return first_term - second_term;
+template <class Model>
+void Estimator::sumLogProbabilities(const double *theta, size_t n, size_t question, int answer, double *out) {
+	sumLogProbabilities<Model>(theta, n, out);
+	Model::addLogProbabilities(theta, n, itemParameters(question), answer, out);
 }
 
-double Estimator::grm_partial_d2LL(double theta, size_t question, int answer) {
-	double P_star1;
-	double P_star2;
-
-	std::tie(P_star2, P_star1) = prob_grm_pair(theta, question, answer);
-
-	double P = P_star1 - P_star2;
-
-	double Q_star1 = 1 - P_star1;
-	double Q_star2 = 1 - P_star2;
-
-	double w2 = P_star2 * Q_star2;
-	double w1 = P_star1 * Q_star1;
-	double w = w1 - w2;
-
-	double first_term = (-w2 * (Q_star2 - P_star2) + w1 * (Q_star1 - P_star1)) / P;
-	double second_term = std::pow(w, 2.0) / std::pow(P, 2.0);
-	return first_term - second_term;
-}
-
-double Estimator::gpcm_partial_d2LL(double theta, size_t question) {
-	return gpcm_partial_d2LL(theta,question,questionSet.answers.at(question));
+template <class Model>
+double Estimator::klOf(double theta_not, int item, double theta) {
+	return Model::kl(theta_not, theta, itemParameters(item));
 }
 
-double Estimator::gpcm_partial_d1LL(double theta, size_t question) {
-
-  	return gpcm_partial_d1LL(theta, question, questionSet.answers.at(question));
-}
-
-
-double Estimator::gpcm_d2LL(double theta) {
-  double d2l = 0.0;
-
-	for (auto question : questionSet.applicable_rows) {
-    	d2l += gpcm_partial_d2LL(theta, question);
+template <class Model>
+std::vector<double> Estimator::klReferenceOf(int item, double theta) {
+	const model::Item parameters = itemParameters(item);
+	std::vector<double> log_probs(Model::categoryCount(parameters));
+	Model::categoryProbabilities(theta, parameters, log_probs.data());
+	for (auto &prob : log_probs) {
+		prob = std::log(prob);
 	}
-	
-	return d2l;
+	return log_probs;
 }
 
-double Estimator::gpcm_d2LL(double theta, size_t question, int answer) {
-  double d2l = 0.0;
-
-	for (auto q : questionSet.applicable_rows) {
-		int a = questionSet.answers.at(q);
-    	d2l += gpcm_partial_d2LL(theta, q, a);
+template <class Model>
+void Estimator::klOf(const double *theta_not, size_t n, int item, const std::vector<double> &reference, double *out) {
+	const model::Item parameters = itemParameters(item);
+	std::vector<double> probs(reference.size());
+	for (size_t i = 0; i < n; ++i) {
+		Model::categoryProbabilities(theta_not[i], parameters, probs.data());
+		out[i] = model::kl(probs.data(), reference.data(), reference.size());
 	}
-	
-	d2l += gpcm_partial_d2LL(theta, question, answer);
-	
-	return d2l;
 }
 
-double Estimator::grm_d2LL(double theta) {
-	double lambda_theta = 0.0;
-	for (auto question : questionSet.applicable_rows) {
-		const double question_discrimination = std::pow(questionSet.discrimination.at(question), 2.0);
-		const double second_derivative = grm_partial_d2LL(theta, (size_t) question);
-
-		lambda_theta += question_discrimination * second_derivative;
-	}
-	return lambda_theta;
+template <class Model>
+void Estimator::useModel() {
+	logLikelihood_kernel = &Estimator::sumAnswers<&Model::logProbability>;
+	logLikelihood_with_kernel = &Estimator::sumAnswers<&Model::logProbability>;
+	d1LL_kernel = &Estimator::sumAnswers<&Model::d1>;
+	d1LL_with_kernel = &Estimator::sumAnswers<&Model::d1>;
+	d2LL_kernel = &Estimator::sumAnswers<&Model::d2>;
+	d2LL_with_kernel = &Estimator::sumAnswers<&Model::d2>;
+	logLikelihood_batch_kernel = &Estimator::sumLogProbabilities<Model>;
+	logLikelihood_batch_with_kernel = &Estimator::sumLogProbabilities<Model>;
+	kl_kernel = &Estimator::klOf<Model>;
+	klReference_kernel = &Estimator::klReferenceOf<Model>;
+	kl_batch_kernel = &Estimator::klOf<Model>;
 }
 
-double Estimator::grm_d2LL(double theta, size_t question, int answer) {
-	double lambda_theta = 0.0;
-	for (auto q : questionSet.applicable_rows) {
-		double question_discrimination = std::pow(questionSet.discrimination.at(q), 2.0);
-		int a = questionSet.answers.at(q);
-		double second_derivative = grm_partial_d2LL(theta, (size_t) q, a);
-		lambda_theta += question_discrimination * second_derivative;
-	}
-
-	double question_discrimination = std::pow(questionSet.discrimination.at(question), 2.0);
-	double second_derivative = grm_partial_d2LL(theta, (size_t) question, answer);
-	lambda_theta += question_discrimination * second_derivative;
-
-	return lambda_theta;
+double Estimator::logLikelihood(double theta) {
+	return (this->*logLikelihood_kernel)(theta);
 }
 
-double Estimator::ltm_d2LL(double theta) {
-	double lambda_theta = 0.0;
-	for (auto question : questionSet.applicable_rows) {
-		const double P = prob_ltm(theta, (size_t) question);
-		const double guess = questionSet.guessing.at(question);
-		const double Q = 1.0 - P;
-		const double lambda_temp = (P - guess) / (1.0 - guess);
-		const double discrimination = questionSet.discrimination.at(question);
-
-		lambda_theta += std::pow(discrimination, 2.0) * std::pow(lambda_temp, 2.0) * (Q / P);
-	}
-	return -lambda_theta;
+double Estimator::likelihood(double theta) {
+	return exp(logLikelihood(theta));
 }
 
-double Estimator::ltm_d2LL(double theta, size_t question, int answer) {
-	double lambda_theta = 0.0;
-	for (auto q : questionSet.applicable_rows) {
-		double P = prob_ltm(theta, (size_t) q);
-		double guess = questionSet.guessing.at(q);
-		double Q = 1.0 - P;
-		double lambda_temp = (P - guess) / (1.0 - guess);
-		double discrimination = questionSet.discrimination.at(q);
-
-		lambda_theta += std::pow(discrimination*lambda_temp, 2.0) * (Q / P);
-	}
-
-	double P = prob_ltm(theta, question);
-	double guess = questionSet.guessing.at(question);
-	double Q = 1.0 - P;
-	double lambda_temp = (P - guess) / (1.0 - guess);
-	double discrimination = questionSet.discrimination.at(question);
-
-	lambda_theta += std::pow(discrimination*lambda_temp, 2.0) * (Q / P);
-
-	return -lambda_theta;
+double Estimator::logLikelihood(double theta, size_t question, int answer){
+	return (this->*logLikelihood_with_kernel)(theta, question, answer);
 }
 
-double Estimator::gpcm_d1LL(double theta) {
-  double d1l = 0.0;
-
-	for (auto question : questionSet.applicable_rows) {
-    d1l += gpcm_partial_d1LL(theta, question);
-	 }
-	
-	return d1l;
+double Estimator::likelihood(double theta, size_t question, int answer) {
+	return exp(logLikelihood(theta, question, answer));
 }
 
-double Estimator::gpcm_d1LL(double theta, size_t question, int answer) {
-  	double d1l = 0.0;
-
-	for (auto q : questionSet.applicable_rows) {
-		int a = questionSet.answers.at(q);
-    	d1l += gpcm_partial_d1LL(theta, q, a);
+void Estimator::likelihood(const double *theta, size_t n, double *out) {
+	(this->*logLikelihood_batch_kernel)(theta, n, out);
+	for (size_t i = 0; i < n; ++i) {
+		out[i] = exp(out[i]);
 	}
-
-	d1l += gpcm_partial_d1LL(theta, question, answer);
-	
-	return d1l;
 }
 
-double Estimator::grm_d1LL(double theta) {
-	double l_theta = 0.0;
-	for (auto question : questionSet.applicable_rows) {
-		int answer_k = questionSet.answers.at(question);
-
-		double P_star2, P_star1;
-		std::tie(P_star2, P_star1) = prob_grm_pair(theta, question, answer_k);
-
-		double Q_star1 = 1.0 - P_star1;
-		double Q_star2 = 1 - P_star2;
-		double P = P_star1 - P_star2;
-		double w2 = P_star2 * Q_star2;
-		double w1 = P_star1 * Q_star1;
-
-		l_theta += (-1*questionSet.discrimination.at(question) * ((w1 - w2) / P));
+void Estimator::likelihood(const double *theta, size_t n, size_t question, int answer, double *out) {
+	(this->*logLikelihood_batch_with_kernel)(theta, n, question, answer, out);
+	for (size_t i = 0; i < n; ++i) {
+		out[i] = exp(out[i]);
 	}
-	return l_theta;
 }
 
-double Estimator::grm_d1LL(double theta, size_t question, int answer) {
-	double l_theta = 0.0;
-	for (auto q : questionSet.applicable_rows) {
-		int answer_k = questionSet.answers.at(q);
-		double P_star2, P_star1;
-		std::tie(P_star2, P_star1) = prob_grm_pair(theta, q, answer_k);
-		double P = P_star1 - P_star2;
-		double w = P_star1 * (1.0 - P_star1) - P_star2 * (1 - P_star2);
-
-		l_theta += (-1*questionSet.discrimination.at(q) * (w/ P));
-	}
-
-	double P_star2, P_star1;
-	std::tie(P_star2, P_star1) = prob_grm_pair(theta, question, answer);
-	double P = P_star1 - P_star2;
-	double w = P_star1 * (1.0 - P_star1) - P_star2 * (1 - P_star2);
-
-	l_theta += (-1*questionSet.discrimination.at(question) * (w / P));
-
-	return l_theta;
+double Estimator::grm_partial_d2LL(double theta, size_t question) {
+	return model::Graded::partial_d2(theta, itemParameters(question), questionSet.answers.at(question));
 }
 
-double Estimator::ltm_d1LL(double theta) {
-	double l_theta = 0;
-	for (auto question : questionSet.applicable_rows) {
-		const double P = prob_ltm(theta, question);
-		const double guess = questionSet.guessing.at(question);
-		const double answer = questionSet.answers.at(question);
-		const double discrimination = questionSet.discrimination.at(question);
-		l_theta += discrimination * ((P - guess) / (P * (1 - guess))) * (answer - P);
-	}
-	return l_theta;
+double Estimator::grm_partial_d2LL(double theta, size_t question, int answer) {
+	return model::Graded::partial_d2(theta, itemParameters(question), answer);
 }
 
-double Estimator::ltm_d1LL(double theta, size_t question, int answer) {
-	double l_theta = 0;
-	for (auto q : questionSet.applicable_rows) {
-		double P = prob_ltm(theta, q);
-		double guess = questionSet.guessing.at(q);
-		double a = questionSet.answers.at(q);
-		double discrimination = questionSet.discrimination.at(q);
-		l_theta += discrimination * ((P - guess) / (P * (1 - guess))) * (a - P);
-	}
-
-	double P = prob_ltm(theta, question);
-	double guess = questionSet.guessing.at(question);
-	double discrimination = questionSet.discrimination.at(question);
-	l_theta += discrimination * ((P - guess) / (P * (1 - guess))) * (answer - P);
-
-	return l_theta;
+double Estimator::gpcm_partial_d2LL(double theta, size_t question) {
+	return gpcm_partial_d2LL(theta,question,questionSet.answers.at(question));
 }
 
-
 double Estimator::d1LL(double theta, bool use_prior, Prior &prior) {
 	const double prior_shift = (theta - prior.param0()) / std::pow(prior.param1(), 2.0);
 	if (questionSet.applicable_rows.empty()) {
 		return prior_shift;
 	}
-	double l_theta = 0.0;
-	
-	if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
-	  l_theta = ltm_d1LL(theta);
-	}
-	if (questionSet.model == "grm") {
-	  l_theta = grm_d1LL(theta);
-	}
-	if (questionSet.model == "gpcm"){
-		l_theta = gpcm_d1LL(theta);
-	}
-	
+	double l_theta = (this->*d1LL_kernel)(theta);
 	return use_prior ? l_theta - prior_shift : l_theta;
 }
 
 double Estimator::d1LL(double theta, bool use_prior, Prior &prior, size_t question, int answer) {
-	double l_theta = 0.0;
-	
-	if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
-	  l_theta = ltm_d1LL(theta, question, answer);
-	}
-	if (questionSet.model == "grm") {
-	  l_theta = grm_d1LL(theta, question, answer);
-	}
-	if (questionSet.model == "gpcm"){
-		l_theta = gpcm_d1LL(theta, question, answer);
-	}
+	double l_theta = (this->*d1LL_with_kernel)(theta, question, answer);
 
 	if (use_prior)
 	{
@@ -882,32 +345,12 @@ double Estimator::d2LL(double theta, bool use_prior, Prior &prior) {
 	if (questionSet.applicable_rows.empty()) {
 		return -prior_shift;
 	}
-	double lambda_theta = 0.0;
-	
-	if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
-	  lambda_theta = ltm_d2LL(theta);
-	}
-	if (questionSet.model == "grm") {
-	  lambda_theta = grm_d2LL(theta);
-	}
-	if (questionSet.model == "gpcm"){
-		lambda_theta = gpcm_d2LL(theta);
-	}
+	double lambda_theta = (this->*d2LL_kernel)(theta);
 	return use_prior ? lambda_theta - prior_shift : lambda_theta;
 }
 
 double Estimator::d2LL(double theta, bool use_prior, Prior &prior, size_t question, int answer) {
-	double lambda_theta = 0.0;
-	
-	if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
-	  lambda_theta = ltm_d2LL(theta, question, answer);
-	}
-	if (questionSet.model == "grm") {
-	  lambda_theta = grm_d2LL(theta, question, answer);
-	}
-	if (questionSet.model == "gpcm"){
-		lambda_theta = gpcm_d2LL(theta, question, answer);
-	}
+	double lambda_theta = (this->*d2LL_with_kernel)(theta, question, answer);
 
 	if(use_prior)
 	{
@@ -918,74 +361,46 @@ double Estimator::d2LL(double theta, bool use_prior, Prior &prior, size_t questi
 
 
 
-Estimator::Estimator(Integrator &integration, QuestionSet &question) : integrator(integration), questionSet(question) { }
-
-double Estimator::polytomous_posterior_variance(int item, Prior &prior) {
-	double theta_old = estimateTheta(prior);
-  
-  	questionSet.applicable_rows.push_back(item);
- 
-	std::vector<double> variances;
-	for (size_t i = 0; i <= questionSet.difficulty.at(item).size(); ++i) {
-		questionSet.answers.at(item) = (int) i + 1;
-		variances.push_back(std::pow(estimateSE(prior), 2.0));
+Estimator::Estimator(Integrator &integration, QuestionSet &question) : integrator(integration), questionSet(question),
+                                                                     gridPosterior(nullptr) {
+	// the only place the model is looked at: everything below calls straight into one policy
+	switch (questionSet.modelType) {
+	case ModelType::LTM:
+	case ModelType::TPM:
+		useModel<model::Binary>();
+		break;
+	case ModelType::GRM:
+		useModel<model::Graded>();
+		break;
+	case ModelType::GPCM:
+		useModel<model::PartialCredit>();
+		break;
 	}
-
-	double sum = 0;
-	if (questionSet.model == "grm") {
-		auto probabilities = prob_grm(theta_old, (size_t) item);
-	  	for (size_t i = 1; i < probabilities.size(); ++i) {
-	    	sum += variances.at(i-1) * (probabilities.at(i) - probabilities.at(i-1));
-	    }
-	}
-	if (questionSet.model == "gpcm"){
-		auto probabilities = prob_gpcm(theta_old, (size_t) item);
-	  	for (size_t i = 0; i < probabilities.size(); ++i) {
-	    	sum += variances.at(i) * probabilities.at(i);
-	    }
-	}
-	
-	questionSet.applicable_rows.pop_back();
-	return sum;
 }
 
-double Estimator::binary_posterior_variance(int item, Prior &prior) {
-  const double prob_incorrect = prob_ltm(estimateTheta(prior), (size_t) item);
-  
-  questionSet.applicable_rows.push_back(item);
-  
-	questionSet.answers.at(item) = 1;
-	double variance_correct = std::pow(estimateSE(prior), 2.0);
-
-	questionSet.answers.at(item) = 0;
-	double variance_incorrect = std::pow(estimateSE(prior), 2.0);
-	
-	questionSet.applicable_rows.pop_back();
-
-	return (prob_incorrect * variance_correct) + ((1.0 - prob_incorrect) * variance_incorrect);
+void Estimator::setGridPosterior(const GridPosterior *posterior) {
+	gridPosterior = (posterior != nullptr && posterior->isActive()) ? posterior : nullptr;
 }
 
 double Estimator::expectedPV(int item, Prior &prior) {
-	double result = 0.0;
-  
-	if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
-	  result = binary_posterior_variance(item, prior);
-	}
-	if (questionSet.model == "grm") {
-	  result = polytomous_posterior_variance(item, prior);
+	return expectedPV(item, selectionContext(prior, SelectionContext::THETA));
+}
+
+double Estimator::expectedPV(int item, const SelectionContext &context) {
+	if (questionSet.modelType == ModelType::GRM) {
+		return expectedPV_grm(item, context);
 	}
-	if (questionSet.model == "gpcm"){
-		result = polytomous_posterior_variance(item, prior);
+	if (questionSet.modelType == ModelType::GPCM) {
+		return expectedPV_gpcm(item, context);
 	}
-	
-	questionSet.answers.at(item) = NA_INTEGER;
-	return result;
+	return expectedPV_ltm_tpm(item, context);
 }
 
-double Estimator::expectedPV_ltm_tpm(int item, Prior &prior)
+double Estimator::expectedPV_ltm_tpm(int item, const SelectionContext &context)
 {
 	//binary_posterior_variance
-	double prob_incorrect = prob_ltm(estimateTheta(prior), (size_t) item);
+	const Prior &prior = context.prior;
+	double prob_incorrect = prob_ltm(context.theta, (size_t) item);
     
 	double variance_correct = std::pow(estimateSE(prior,item,1), 2.0);
 	double variance_incorrect = std::pow(estimateSE(prior,item,0), 2.0);
@@ -993,25 +408,25 @@ double Estimator::expectedPV_ltm_tpm(int item, Prior &prior)
 	return (prob_incorrect * variance_correct) + ((1.0 - prob_incorrect) * variance_incorrect);
 }
 
-double Estimator::expectedPV_grm(int item, Prior &prior)
+double Estimator::expectedPV_grm(int item, const SelectionContext &context)
 {
 	//polytomous_posterior_variance
 	double sum = 0;
-	auto probabilities = prob_grm(estimateTheta(prior), (size_t) item);
+	auto probabilities = prob_grm(context.theta, (size_t) item);
   	for (size_t i = 1; i < probabilities.size(); ++i) {
-  		double var = std::pow(estimateSE(prior,item,(int)i), 2.0);
+  		double var = std::pow(estimateSE(context.prior,item,(int)i), 2.0);
     	sum += var * (probabilities.at(i) - probabilities.at(i-1));
     }
 	return sum;
 }
 
-double Estimator::expectedPV_gpcm(int item, Prior &prior)
+double Estimator::expectedPV_gpcm(int item, const SelectionContext &context)
 {
 	//polytomous_posterior_variance
 	double sum = 0;
-	auto probabilities = prob_gpcm(estimateTheta(prior), (size_t) item);
+	auto probabilities = prob_gpcm(context.theta, (size_t) item);
   	for (size_t i = 0; i < probabilities.size(); ++i) {
-  		double var = std::pow(estimateSE(prior,item,(int) i + 1), 2.0);
+  		double var = std::pow(estimateSE(context.prior,item,(int) i + 1), 2.0);
     	sum += var * probabilities.at(i);
     }
 	
@@ -1019,10 +434,10 @@ double Estimator::expectedPV_gpcm(int item, Prior &prior)
 }
 
 double Estimator::obsInf(double theta, int item) {
-	if(questionSet.model == "grm"){
+	if(questionSet.modelType == ModelType::GRM){
 	  return obsInf_grm(theta, item);
 	}	
-	else if(questionSet.model == "gpcm"){
+	else if(questionSet.modelType == ModelType::GPCM){
 	  return obsInf_gpcm(theta, item);
 	}
 	else
@@ -1032,10 +447,10 @@ double Estimator::obsInf(double theta, int item) {
 }
 
 double Estimator::obsInf(double theta, int item, int answer) {
-	if(questionSet.model == "grm"){
+	if(questionSet.modelType == ModelType::GRM){
 	  return obsInf_grm(theta, item, answer);
 	}	
-	else if(questionSet.model == "gpcm"){
+	else if(questionSet.modelType == ModelType::GPCM){
 	  return obsInf_gpcm(theta, item, answer);
 	}
 	else
@@ -1081,13 +496,13 @@ double Estimator::obsInf_ltm(double theta, int item, int answer)
 
 double Estimator::fisherInf(double theta, int item) {
 
-	if ((questionSet.model == "ltm") || (questionSet.model == "tpm")) {
+	if ((questionSet.modelType == ModelType::LTM) || (questionSet.modelType == ModelType::TPM)) {
 		return obsInf_ltm(theta, item);
 	}
 
 	double output = 0.0;
 
-	if (questionSet.model == "grm") {
+	if (questionSet.modelType == ModelType::GRM) {
 		double discrimination_squared = std::pow(questionSet.discrimination.at(item), 2.0);
 		auto probabilities = prob_grm(theta, (size_t) item);
 	  	for (size_t i = 1; i <= questionSet.difficulty.at(item).size() + 1; ++i) {
@@ -1098,7 +513,7 @@ double Estimator::fisherInf(double theta, int item) {
 		  output += discrimination_squared * (std::pow(w1 - w2, 2.0) / (P_star1 - P_star2));
 		}
 	}
-	else if (questionSet.model == "gpcm"){
+	else if (questionSet.modelType == ModelType::GPCM){
 		std::vector<double> probs;
 	  	std::vector<double> prob_firstderiv;
 		std::vector<double> prob_secondderiv;
@@ -1114,15 +529,75 @@ double Estimator::fisherInf(double theta, int item) {
 	return output;
 }
 
+std::vector<double> Estimator::fisherInf(double theta, const std::vector<int> &items) {
+	std::vector<double> information(items.size());
+
+	if ((questionSet.modelType == ModelType::LTM) || (questionSet.modelType == ModelType::TPM)) {
+		if(theta > 20.0 || theta < -20.0){
+			std::string msg = "Theta value " + std::to_string(theta) + " too extreme for numerical routines to provide reliable calculations.  Try using less extreme values for theta.  If using MAP estimation, try EAP instead.";
+			throw model::NumericalError(msg);
+		}
+
+		std::vector<double> difficulty(items.size()), discrimination(items.size()), guessing(items.size());
+		for (size_t i = 0; i < items.size(); ++i) {
+			difficulty[i] = questionSet.difficulty[items[i]][0];
+			discrimination[i] = questionSet.discrimination[items[i]];
+			guessing[i] = questionSet.guessing[items[i]];
+		}
+
+		std::vector<double> P(items.size());
+		kernels::ltm_probability_items(theta, items.size(), difficulty.data(), discrimination.data(), guessing.data(), P.data());
+
+		// same as obsInf_ltm, one item per element
+		for (size_t i = 0; i < items.size(); ++i) {
+			double temp = (P[i] - guessing[i]) / (1.0 - guessing[i]);
+			information[i] = discrimination[i] * discrimination[i] * temp * temp * ((1.0 - P[i]) / P[i]);
+		}
+		return information;
+	}
+
+	for (size_t i = 0; i < items.size(); ++i) {
+		information[i] = fisherInf(theta, items[i]);
+	}
+	return information;
+}
+
+void Estimator::fisherInf(const double *theta, size_t n, int item, double *out) {
+	if ((questionSet.modelType == ModelType::LTM) || (questionSet.modelType == ModelType::TPM)) {
+		for (size_t i = 0; i < n; ++i) {
+			if (theta[i] > 20.0 || theta[i] < -20.0) {
+				model::extreme_theta(theta[i]);
+			}
+		}
+
+		const model::Item parameters = itemParameters(item);
+		kernels::ltm_probability(theta, n, parameters.thresholds[0], parameters.discrimination, parameters.guessing, out);
+
+		// same as obsInf_ltm, one theta per element
+		const double discrimination = parameters.discrimination;
+		const double guess = parameters.guessing;
+		for (size_t i = 0; i < n; ++i) {
+			const double P = out[i];
+			const double temp = (P - guess) / (1.0 - guess);
+			out[i] = discrimination * discrimination * temp * temp * ((1.0 - P) / P);
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < n; ++i) {
+		out[i] = fisherInf(theta[i], item);
+	}
+}
+
 double Estimator::fisherInf(double theta, int item, int answer) {
 
-	if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
+	if ((questionSet.modelType == ModelType::LTM) | (questionSet.modelType == ModelType::TPM)) {
 		return obsInf_ltm(theta, item, answer);
 	}
 
 	double output = 0.0;
 
-	if (questionSet.model == "grm") {
+	if (questionSet.modelType == ModelType::GRM) {
 		double discrimination_squared = std::pow(questionSet.discrimination.at(item), 2.0);
 		auto probabilities = prob_grm(theta, (size_t) item);
 	  	for (size_t i = 1; i <= questionSet.difficulty.at(item).size() + 1; ++i) {
@@ -1133,7 +608,7 @@ double Estimator::fisherInf(double theta, int item, int answer) {
 		  output += discrimination_squared * (std::pow(w1 - w2, 2.0) / (P_star1 - P_star2));
 		}
 	}	
-	else if (questionSet.model == "gpcm"){
+	else if (questionSet.modelType == ModelType::GPCM){
 		std::vector<double> probs;
 	  	std::vector<double> prob_firstderiv;
 		std::vector<double> prob_secondderiv;
@@ -1150,90 +625,50 @@ double Estimator::fisherInf(double theta, int item, int answer) {
 }
 
 double Estimator::expectedObsInf(int item, Prior &prior) {
+	const SelectionContext context = selectionContext(prior, SelectionContext::THETA);
 
-	
-	if (questionSet.model == "grm"){
-		auto probabilities = prob_grm(estimateTheta(prior), (size_t) item);
-	  	
-	  	questionSet.applicable_rows.push_back(item);
-
-		double sum = 0.0;
-	  	for (size_t i = 1; i < probabilities.size(); ++i) {
-	  		questionSet.answers.at(item) = (int) i;
-			double obsinfo = obsInf_grm(estimateTheta(prior), item);
-	    	sum += obsinfo * (probabilities.at(i) - probabilities.at(i-1));
-     	}
-
-		questionSet.answers.at(item) = NA_INTEGER;
-		questionSet.applicable_rows.pop_back();
-		
-		return sum;
+	if (questionSet.modelType == ModelType::GRM) {
+		return expectedObsInf_grm(item, context);
 	}
-	else if (questionSet.model == "gpcm"){
-		auto probabilities = prob_gpcm(estimateTheta(prior), (size_t) item);
-
-	  	questionSet.applicable_rows.push_back(item);
-	  
-		double sum = 0.0;
-	  	for (size_t i = 0; i < probabilities.size(); ++i) {
-	  		questionSet.answers.at(item) = (int) i + 1;
-			double obsinfo = obsInf_gpcm(estimateTheta(prior), item);
-      		sum += obsinfo * probabilities.at(i);
-    	}
-
-		questionSet.answers.at(item) = NA_INTEGER;
-		questionSet.applicable_rows.pop_back();
-				
-		return sum;
+	if (questionSet.modelType == ModelType::GPCM) {
+		return expectedObsInf_gpcm(item, context);
 	}
-
-	double prob_one = prob_ltm(estimateTheta(prior), (size_t) item);
-	questionSet.applicable_rows.push_back(item);
-	
-	questionSet.answers.at(item) = 0;
-	double obsInfZero = obsInf_ltm(estimateTheta(prior), item);
-	questionSet.answers.at(item) = 1;
-	double obsInfOne = obsInf_ltm(estimateTheta(prior), item);
-	
-	questionSet.applicable_rows.pop_back();
-	questionSet.answers.at(item) = NA_INTEGER;
-
-	return (prob_one * obsInfOne) + ((1 - prob_one) * obsInfZero);
+	return expectedObsInf_rest(item, context);
 }
 
-double Estimator::expectedObsInf_grm(int item, Prior &prior)
+double Estimator::expectedObsInf_grm(int item, const SelectionContext &context)
 {
-	std::vector<double> probabilities = prob_grm(estimateTheta(prior), (size_t) item);
+	std::vector<double> probabilities = prob_grm(context.theta, (size_t) item);
 	double sum = 0.0;
 
 	for(size_t i = 1; i < probabilities.size(); ++i){
-	    sum += obsInf_grm(estimateTheta(prior,item,(int)i), item, (int)i) * (probabilities.at(i) - probabilities.at(i-1));
+	    sum += obsInf_grm(estimateTheta(context.prior,item,(int)i), item, (int)i) * (probabilities.at(i) - probabilities.at(i-1));
     }
 
 	return sum;
 }
 
-double Estimator::expectedObsInf_gpcm(int item, Prior &prior)
+double Estimator::expectedObsInf_gpcm(int item, const SelectionContext &context)
 {
-	std::vector<double> probabilities = prob_gpcm(estimateTheta(prior), (size_t) item);
+	std::vector<double> probabilities = prob_gpcm(context.theta, (size_t) item);
 	double sum = 0.0;
 	
 	for (size_t i = 0; i < probabilities.size(); ++i) {
-	      sum += obsInf_gpcm(estimateTheta(prior,item,(int) i + 1), item, (int) i + 1) * probabilities.at(i);
+	      sum += obsInf_gpcm(estimateTheta(context.prior,item,(int) i + 1), item, (int) i + 1) * probabilities.at(i);
 	}
 
 	return sum;
 }
 
-double Estimator::expectedObsInf_rest(int item, Prior &prior)
+double Estimator::expectedObsInf_rest(int item, const SelectionContext &context)
 {
-	double prob_one = prob_ltm(estimateTheta(prior), (size_t) item);
-	double obsInfZero = obsInf_ltm(estimateTheta(prior, item, 0), item, 0);
-	double obsInfOne = obsInf_ltm(estimateTheta(prior, item, 1), item, 1);
+	double prob_one = prob_ltm(context.theta, (size_t) item);
+	double obsInfZero = obsInf_ltm(estimateTheta(context.prior, item, 0), item, 0);
+	double obsInfOne = obsInf_ltm(estimateTheta(context.prior, item, 1), item, 1);
 	return (prob_one * obsInfOne) + ((1 - prob_one) * obsInfZero);
 }
 
-double Estimator::brentMethod(integrableFunction function){
+double Estimator::brentMethod(gsl_function *F){
   int status;
   int iter = 0;
   int max_iter = 100;
@@ -1245,9 +680,6 @@ double Estimator::brentMethod(integrableFunction function){
   double x_lo = -5.0;
   double x_hi = 5.0;
   
-  auto gslfunc = GSLFunctionWrapper(function);
-  gsl_function *F = gslfunc.asGSLFunction();
-  
 
   T = gsl_root_fsolver_brent; //can change this to whatever method ex. _bisection
   s = gsl_root_fsolver_alloc (T);
@@ -1286,8 +718,8 @@ double Estimator::brentMethod(integrableFunction function){
   return r;
 }
 
-//This version of the function is only for plotting.
-//It is not intented to be used for anything else in the package.
+//This version of the function is for plotting, and for the test information
+//of a selection round, which already holds the estimate of theta.
 double Estimator::fisherTestInfo(double theta) {
     double sum = 0.0;
     for (auto item : questionSet.applicable_rows) {
@@ -1325,33 +757,74 @@ double Estimator::fisherTestInfo(Prior prior, size_t question, int answer)
  * function will call in a loop
  */
 
-double Estimator::pwi(int item, Prior prior) {
+SelectionContext Estimator::selectionContext(Prior &prior, unsigned needs) {
+	const double nan = std::numeric_limits<double>::quiet_NaN();
+	SelectionContext context{prior, nan, nan, nan, gridPosterior};
+	if (needs & (SelectionContext::THETA | SelectionContext::TEST_INFO)) {
+		context.theta = estimateTheta(prior);
+	}
+	if (needs & SelectionContext::SE) {
+		context.se = estimateSE(prior);
+	}
+	if (needs & SelectionContext::TEST_INFO) {
+		context.testInfo = fisherTestInfo(context.theta);
+	}
+	if (gridPosterior && (needs & SelectionContext::LIKELIHOOD_WEIGHTS)) {
+		context.likelihoodWeights = gridPosterior->integrationWeights(false);
+	}
+	if (gridPosterior && (needs & SelectionContext::POSTERIOR_WEIGHTS)) {
+		context.posteriorWeights = gridPosterior->integrationWeights(true);
+	}
+	return context;
+}
+
+double Estimator::pwi(int item, const SelectionContext &context) {
+	if (context.posterior) {
+		return context.posterior->integrate(context.posterior->getTables().information(item), true);
+	}
+
+	const Prior &prior = context.prior;
 
-	integrableFunction pwi_j = [&](double theta) {
-		return likelihood(theta) * prior.prior(theta) * fisherInf(theta, item);
+	std::vector<double> information;
+	auto pwi_j = [&](const double *theta, size_t n, double *out) {
+		information.resize(n);
+		likelihood(theta, n, out);
+		fisherInf(theta, n, item, information.data());
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = out[i] * prior.prior(theta[i]) * information[i];
+		}
 	};
 
 	return integrate_selectItem(pwi_j, questionSet.lowerBound, questionSet.upperBound);
 }
 
-double Estimator::lwi(int item) {
+double Estimator::lwi(int item, const SelectionContext &context) {
+	if (context.posterior) {
+		return context.posterior->integrate(context.posterior->getTables().information(item), false);
+	}
 
-	integrableFunction lwi_j = [&](double theta) {
-		return likelihood(theta) * fisherInf(theta, item);
+	std::vector<double> information;
+	auto lwi_j = [&](const double *theta, size_t n, double *out) {
+		information.resize(n);
+		likelihood(theta, n, out);
+		fisherInf(theta, n, item, information.data());
+		for (size_t i = 0; i < n; ++i) {
+			out[i] *= information[i];
+		}
 	};
 
 	return integrate_selectItem(lwi_j, questionSet.lowerBound, questionSet.upperBound);
 }
 
-double Estimator::fii(int item, Prior prior) {
+double Estimator::fii(int item, const SelectionContext &context) {
   
-	integrableFunction fii_j = [&](double theta_not) {
-		return fisherInf(theta_not, item);
+	auto fii_j = [&](const double *theta_not, size_t n, double *out) {
+		fisherInf(theta_not, n, item, out);
 	};
 	  
-  double delta = questionSet.z.at(0) * std::pow(fisherTestInfo(prior), 0.5);
+  double delta = questionSet.z.at(0) * std::pow(context.testInfo, 0.5);
   
-  double theta = estimateTheta(prior);
+  double theta = context.theta;
   const double lower = theta - delta;
   const double upper = theta + delta;
 
@@ -1359,48 +832,29 @@ double Estimator::fii(int item, Prior prior) {
 }
 
 double Estimator::kl(double theta_not, int item, double theta){
-  	double sum = 0.0;
-  
-  	if(questionSet.model == "grm"){
-    	auto cdf_theta_not = prob_grm(theta_not, (size_t) item);
-	  	auto cdf_theta_hat = prob_grm(theta, (size_t) item);
-	  
-	  	for (size_t i = 1; i < cdf_theta_hat.size(); ++i) {
-	    	double prob_theta_not = cdf_theta_not.at(i) - cdf_theta_not.at(i-1);
-	    	double prob_theta_hat = cdf_theta_hat.at(i) - cdf_theta_hat.at(i-1);
-	    	sum += prob_theta_not * (log(prob_theta_not) - log(prob_theta_hat));
-	  	}
-	}
-  
-  	if(questionSet.model == "gpcm"){
-    	auto prob_theta_not = prob_gpcm(theta_not, (size_t) item);
-	  	auto prob_theta_hat = prob_gpcm(theta, (size_t) item);
-	  
-	  	for (size_t i = 0; i < prob_theta_not.size(); ++i) {
-	  	  	sum += prob_theta_not.at(i) * (log(prob_theta_not.at(i)) - log(prob_theta_hat.at(i)));
-	  	}
-  	}
-  
-  	if((questionSet.model == "ltm") || (questionSet.model == "tpm")){
-    	const double prob_theta_not = prob_ltm(theta_not, (size_t) item);
-    	const double prob_theta_hat = prob_ltm(theta, (size_t) item);
+	return (this->*kl_kernel)(theta_not, item, theta);
+}
 
-    	double first_term = prob_theta_not * (log(prob_theta_not) - log(prob_theta_hat));
-    	double second_term = (1 - prob_theta_not) * (log(1 - prob_theta_not) - log(1 - prob_theta_hat));
+std::vector<double> Estimator::klReference(int item, double theta) {
+	return (this->*klReference_kernel)(item, theta);
+}
 
-    	sum = first_term + second_term;
-  	}
-  
-  	return sum;
+void Estimator::kl(const double *theta_not, size_t n, int item, const std::vector<double> &reference, double *out) {
+	(this->*kl_batch_kernel)(theta_not, n, item, reference, out);
 }
 
 double Estimator::expectedKL(int item, Prior prior) {
-	double theta = estimateTheta(prior);
-	integrableFunction kl_fctn = [&](double theta_not) {
-	  return kl(theta_not, item, theta);
-  };
+	return expectedKL(item, selectionContext(prior, SelectionContext::TEST_INFO));
+}
+
+double Estimator::expectedKL(int item, const SelectionContext &context) {
+	double theta = context.theta;
+	const std::vector<double> reference = klReference(item, theta);
+	auto kl_fctn = [&](const double *theta_not, size_t n, double *out) {
+		kl(theta_not, n, item, reference, out);
+	};
   
-  double delta = questionSet.z.at(0) * std::pow(fisherTestInfo(prior), 0.5);
+  double delta = questionSet.z.at(0) * std::pow(context.testInfo, 0.5);
   
   const double lower = theta - delta;
   const double upper = theta + delta;
@@ -1409,29 +863,76 @@ double Estimator::expectedKL(int item, Prior prior) {
 }
 
 double Estimator::likelihoodKL(int item, Prior prior) {
-	double theta = estimateTheta(prior);
-	integrableFunction kl_fctn = [&](double theta_not) {
-	  return likelihood(theta_not) * kl(theta_not, item, theta);
-  };
-
-  return integrate_selectItem(kl_fctn, questionSet.lowerBound, questionSet.upperBound);
+	return likelihoodKL(item, selectionContext(prior, SelectionContext::THETA));
 }
 
-double Estimator::posteriorKL(int item, Prior prior) {
-	double theta = estimateTheta(prior);
-	integrableFunction kl_fctn = [&](double theta_not) {
-	  return prior.prior(theta_not) * likelihood(theta_not) * kl(theta_not, item, theta);
-  };
+double Estimator::likelihoodKL(int item, const SelectionContext &context) {
+	double theta = context.theta;
+	if (context.posterior) {
+		const std::vector<double> values = kl_grid(item, theta);
+		if (!context.likelihoodWeights.empty()) {
+			return std::inner_product(values.begin(), values.end(), context.likelihoodWeights.begin(), 0.0);
+		}
+		return context.posterior->integrate(values.data(), false);
+	}
+
+	const std::vector<double> reference = klReference(item, theta);
+	std::vector<double> divergence;
+	auto kl_fctn = [&](const double *theta_not, size_t n, double *out) {
+		divergence.resize(n);
+		likelihood(theta_not, n, out);
+		kl(theta_not, n, item, reference, divergence.data());
+		for (size_t i = 0; i < n; ++i) {
+			out[i] *= divergence[i];
+		}
+	};
 
   return integrate_selectItem(kl_fctn, questionSet.lowerBound, questionSet.upperBound);
 }
 
-double Estimator::integrate_selectItem(const integrableFunction &function, const double lower, const double upper){
-  auto gslfunc = GSLFunctionWrapper(function);
-  gsl_function *f = gslfunc.asGSLFunction();
-  return integrator.integrate(f, integrationSubintervals, lower, upper);
+double Estimator::posteriorKL(int item, Prior prior) {
+	return posteriorKL(item, selectionContext(prior, SelectionContext::THETA));
 }
 
+double Estimator::posteriorKL(int item, const SelectionContext &context) {
+	const Prior &prior = context.prior;
+	double theta = context.theta;
+	if (context.posterior) {
+		const std::vector<double> values = kl_grid(item, theta);
+		if (!context.posteriorWeights.empty()) {
+			return std::inner_product(values.begin(), values.end(), context.posteriorWeights.begin(), 0.0);
+		}
+		return context.posterior->integrate(values.data(), true);
+	}
+
+	const std::vector<double> reference = klReference(item, theta);
+	std::vector<double> divergence;
+	auto kl_fctn = [&](const double *theta_not, size_t n, double *out) {
+		divergence.resize(n);
+		likelihood(theta_not, n, out);
+		kl(theta_not, n, item, reference, divergence.data());
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = prior.prior(theta_not[i]) * out[i] * divergence[i];
+		}
+	};
+
+  return integrate_selectItem(kl_fctn, questionSet.lowerBound, questionSet.upperBound);
+}
 
+std::vector<double> Estimator::kl_grid(int item, double theta) {
+	const ItemTables &tables = gridPosterior->getTables();
+	const size_t categories = tables.categories(item);
+	const double *probs = tables.probabilities(item);
+	const double *log_probs = tables.logProbabilities(item);
 
+	const std::vector<double> log_probs_hat = klReference(item, theta);
 
+	std::vector<double> values(tables.nodeCount(), 0.0);
+	for (size_t i = 0; i < values.size(); ++i) {
+		for (size_t c = 0; c < categories; ++c) {
+			const size_t at = i * categories + c;
+			values[i] += probs[at] * (log_probs[at] - log_probs_hat[c]);
+		}
+	}
+	return values;
+}
@@ -5,6 +5,10 @@
 #include "Integrator.h"
 #include "QuestionSet.h"
 #include "Prior.h"
+#include "GridPosterior.h"
+#include "ModelPolicy.h"
+#include "SelectionContext.h"
+#include "GSLFunctionWrapper.h"
 
 enum class EstimationType {
 	EAP, MAP, MLE, WLE
@@ -29,6 +33,22 @@ public:
 	double likelihood(double theta);
 	double likelihood(double theta, size_t question, int answer);
 
+	double logLikelihood(double theta);
+	double logLikelihood(double theta, size_t question, int answer);
+
+	/**
+	 * The likelihood at each of n thetas, for batch integrands. Binary models evaluate each item at all thetas
+	 * with one batch kernel.
+	 */
+	void likelihood(const double *theta, size_t n, double *out);
+	void likelihood(const double *theta, size_t n, size_t question, int answer, double *out);
+
+	/**
+	 * Sessions with fixed quadrature keep the answered items' log-likelihood on the grid. Once attached, EAP
+	 * estimation and the posterior-weighted selection criteria read it instead of looping over applicable_rows.
+	 */
+	void setGridPosterior(const GridPosterior *posterior);
+
 	std::vector<double> probability(double theta, size_t question);
 
 	double obsInf(double theta, int item);
@@ -43,31 +63,55 @@ public:
 	double fisherInf(double theta, int item);
 	double fisherInf(double theta, int item, int answer);
 
+	/**
+	 * Fisher information of several items at one theta. Binary models evaluate all items with one batch kernel.
+	 */
+	std::vector<double> fisherInf(double theta, const std::vector<int> &items);
+
+	/**
+	 * Fisher information of one item at each of n thetas.
+	 */
+	void fisherInf(const double *theta, size_t n, int item, double *out);
+
+	/**
+	 * expectedPV and expectedObsInf score the hypothetical answers through the (question, answer) overloads of
+	 * estimateTheta and estimateSE, so, like the rest of the estimator, they leave questionSet untouched and may be
+	 * called from worker threads.
+	 */
 	virtual double expectedPV(int item, Prior &prior);
-	virtual double expectedPV_ltm_tpm(int item, Prior &prior);
-	virtual double expectedPV_grm(int item, Prior &prior);
-	virtual double expectedPV_gpcm(int item, Prior &prior);
+	double expectedPV(int item, const SelectionContext &context);
+	virtual double expectedPV_ltm_tpm(int item, const SelectionContext &context);
+	virtual double expectedPV_grm(int item, const SelectionContext &context);
+	virtual double expectedPV_gpcm(int item, const SelectionContext &context);
 
 	double expectedObsInf(int item, Prior &prior);
-	double expectedObsInf_grm(int item, Prior &prior);
-	double expectedObsInf_gpcm(int item, Prior &prior);
-	double expectedObsInf_rest(int item, Prior &prior);
+	double expectedObsInf_grm(int item, const SelectionContext &context);
+	double expectedObsInf_gpcm(int item, const SelectionContext &context);
+	double expectedObsInf_rest(int item, const SelectionContext &context);
 
 	double fisherTestInfo(double theta);	
 	double fisherTestInfo(Prior prior);
 	double fisherTestInfo(Prior prior, size_t question, int answer);
 	
-	double pwi(int item, Prior prior);
+	/**
+	 * Computes the fields of a SelectionContext named in needs (SelectionContext::Need flags) once per round.
+	 */
+	SelectionContext selectionContext(Prior &prior, unsigned needs);
+
+	double pwi(int item, const SelectionContext &context);
 	
-	double lwi(int item);
+	double lwi(int item, const SelectionContext &context);
 	
-	double fii(int item, Prior prior);
+	double fii(int item, const SelectionContext &context);
 	
 	double expectedKL(int item, Prior prior);
+	double expectedKL(int item, const SelectionContext &context);
 	
 	double likelihoodKL(int item, Prior prior);
+	double likelihoodKL(int item, const SelectionContext &context);
 	
 	double posteriorKL(int item, Prior prior);
+	double posteriorKL(int item, const SelectionContext &context);
 	
 	double d1LL(double theta, bool use_prior, Prior &prior);
 	double d1LL(double theta, bool use_prior, Prior &prior, size_t question, int answer);
@@ -95,17 +139,45 @@ protected:
 	double kl(double theta_not, int item, double theta);
 
 	/**
-	 * GSL's integration library requires a function taking a double (and, optionally, a void pointer),
-	 * and returning a double. To make things easier for usage here, a std::function with those parameters
-	 * is typedef-ed as integrableFunction. If integralQuotient is ever moved into Integrator (which it probably should
-	 * be), then this should be moved as well, and made public.
+	 * The log category probabilities of item at theta, the side of kl() that stays fixed while a KL integrand is
+	 * evaluated; the KL criteria compute it once per item.
 	 */
-	typedef std::function<double(double)> integrableFunction;
-	
-	//double brentMethod(const integrableFunction &function);
-	double brentMethod(integrableFunction function);
-	
-	double integrate_selectItem(const integrableFunction &function, const double lower, const double upper);
+	std::vector<double> klReference(int item, double theta);
+
+	/**
+	 * kl(theta_not[i], item, theta) for i < n, with the theta side taken from reference = klReference(item, theta).
+	 */
+	void kl(const double *theta_not, size_t n, int item, const std::vector<double> &reference, double *out);
+
+	/**
+	 * GSL's root finder requires a function taking a double (and, optionally, a void pointer), and returning
+	 * a double. Any callable with that signature is wrapped in a GSLFunctionWrapper of its own type, so GSL
+	 * calls it directly rather than through a std::function.
+	 */
+	template <class Function>
+	double brentMethod(const Function &function) {
+		GSLFunctionWrapper<Function> wrapper(function);
+		return brentMethod(wrapper.asGSLFunction());
+	}
+
+	double brentMethod(gsl_function *F);
+
+	/**
+	 * Integrates a batch integrand, a callable taking (const double *theta, size_t n, double *out) that fills
+	 * out with the integrand at all n thetas, as Integrator::integrateBatch does.
+	 */
+	template <class Function>
+	double integrate_selectItem(const Function &function, const double lower, const double upper) {
+		return integrator.integrateBatch(function, integrationSubintervals, lower, upper);
+	}
+
+	/**
+	 * kl(theta_not, item, theta) at every node of the attached GridPosterior, with the theta_not side read
+	 * from the item tables.
+	 */
+	std::vector<double> kl_grid(int item, double theta);
+
+	const GridPosterior *gridPosterior;
 
 private:
 	/**
@@ -117,40 +189,57 @@ private:
   
     
   
-  double likelihood_ltm(double theta);
-	double likelihood_grm(double theta);
-	double likelihood_gpcm(double theta);
+	/**
+	 * One item's parameters in the form the ModelPolicy.h policies take them.
+	 */
+	model::Item itemParameters(size_t question) const;
 
-	double likelihood_ltm(double theta, size_t question, int answer);
-	double likelihood_grm(double theta, size_t question, int answer);
-	double likelihood_gpcm(double theta, size_t question, int answer);
-  
-  double grm_d1LL(double theta);
-	double gpcm_d1LL(double theta);
-	double ltm_d1LL(double theta);
+	/**
+	 * The likelihood and its derivatives are sums of one policy's per-item terms over applicable_rows (plus, for
+	 * the overloads taking a question and answer, one hypothetical item). These templates are instantiated for each
+	 * policy, and useModel picks the instantiations for the bank's model once, in the constructor, so the sums
+	 * no longer compare model strings on every evaluation.
+	 */
+	template <double (*Term)(double, const model::Item &, int)>
+	double sumAnswers(double theta);
+	template <double (*Term)(double, const model::Item &, int)>
+	double sumAnswers(double theta, size_t question, int answer);
+
+	template <class Model>
+	void sumLogProbabilities(const double *theta, size_t n, double *out);
+	template <class Model>
+	void sumLogProbabilities(const double *theta, size_t n, size_t question, int answer, double *out);
+
+	template <class Model>
+	double klOf(double theta_not, int item, double theta);
+	template <class Model>
+	std::vector<double> klReferenceOf(int item, double theta);
+	template <class Model>
+	void klOf(const double *theta_not, size_t n, int item, const std::vector<double> &reference, double *out);
+
+	template <class Model>
+	void useModel();
+
+	double (Estimator::*logLikelihood_kernel)(double theta);
+	double (Estimator::*logLikelihood_with_kernel)(double theta, size_t question, int answer);
+	double (Estimator::*d1LL_kernel)(double theta);
+	double (Estimator::*d1LL_with_kernel)(double theta, size_t question, int answer);
+	double (Estimator::*d2LL_kernel)(double theta);
+	double (Estimator::*d2LL_with_kernel)(double theta, size_t question, int answer);
+	void (Estimator::*logLikelihood_batch_kernel)(const double *theta, size_t n, double *out);
+	void (Estimator::*logLikelihood_batch_with_kernel)(const double *theta, size_t n, size_t question, int answer,
+	                                                   double *out);
+	double (Estimator::*kl_kernel)(double theta_not, int item, double theta);
+	std::vector<double> (Estimator::*klReference_kernel)(int item, double theta);
+	void (Estimator::*kl_batch_kernel)(const double *theta_not, size_t n, int item, const std::vector<double> &reference,
+	                                   double *out);
 
-	double grm_d1LL(double theta, size_t question, int answer);
-	double gpcm_d1LL(double theta, size_t question, int answer);
-	double ltm_d1LL(double theta, size_t question, int answer);
-	
 	double grm_partial_d2LL(double theta, size_t question);	
 	double gpcm_partial_d2LL(double theta, size_t question);	
-	double gpcm_partial_d1LL(double theta, size_t question);	
 
 	double grm_partial_d2LL(double theta, size_t question, int answer);	
 	double gpcm_partial_d2LL(double theta, size_t question, int answer);	
-	double gpcm_partial_d1LL(double theta, size_t question, int answer);	
-
-  double grm_d2LL(double theta);
-	double gpcm_d2LL(double theta);
-	double ltm_d2LL(double theta);
-
-	double grm_d2LL(double theta, size_t question, int answer);
-	double gpcm_d2LL(double theta, size_t question, int answer);
-	double ltm_d2LL(double theta, size_t question, int answer);
 
-	double polytomous_posterior_variance(int item, Prior &prior);
-	double binary_posterior_variance(int item, Prior &prior);
 	
 
 };
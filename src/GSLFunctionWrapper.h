@@ -1,23 +1,32 @@
 #include <gsl/gsl_integration.h>
-#include <functional>
 #pragma once
 
 /**
  * GSL's integration library requires a function that conforms
  * to gsl_function. This template class enables lambdas which
  * would otherwise meet the requirements to be used as gsl_functions.
- * If this ends up being too slow, std::function can be replaced with a
- * template class.
+ * The callable's type is a template parameter, so GSL's calls go
+ * straight to it rather than through a std::function. The wrapper
+ * only refers to the callable, which must outlive it.
  */
 
+template <class Function>
 class GSLFunctionWrapper : public gsl_function {
 public:
-	GSLFunctionWrapper(std::function<double(double)> const &func);
+	GSLFunctionWrapper(const Function &func) : _func(func) {
+		function = &GSLFunctionWrapper::invoke;
+		params = this;
+	}
 
-	gsl_function * asGSLFunction();
+	gsl_function * asGSLFunction() {
+		params = this;
+		return static_cast<gsl_function*>(this);
+	}
 
 private:
-	std::function<double(double)> _func;
+	const Function &_func;
 
-	static double invoke(double x, void *params);
-};
\ No newline at end of file
+	static double invoke(double x, void *params) {
+		return static_cast<GSLFunctionWrapper *>(params)->_func(x);
+	}
+};
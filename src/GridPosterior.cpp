@@ -0,0 +1,133 @@
+#include "GridPosterior.h"
+#include <algorithm>
+#include <cmath>
+
+GridPosterior::GridPosterior(const Integrator &integrator, const Prior &prior) : integrator(integrator) {
+	const std::vector<double> &nodes = integrator.getNodes();
+	log_likelihood.assign(nodes.size(), 0.0);
+	log_prior.resize(nodes.size());
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		log_prior[i] = std::log(prior.prior(nodes[i]));
+	}
+}
+
+bool GridPosterior::isActive() const {
+	return !integrator.isAdaptive();
+}
+
+void GridPosterior::reset(const QuestionSet &questionSet, std::shared_ptr<const ItemTables> itemTables) {
+	tables = itemTables;
+	std::fill(log_likelihood.begin(), log_likelihood.end(), 0.0);
+	for (auto question : questionSet.applicable_rows) {
+		addAnswer(question, questionSet.answers.at(question));
+	}
+}
+
+void GridPosterior::addAnswer(size_t question, int answer) {
+	for (size_t i = 0; i < log_likelihood.size(); ++i) {
+		log_likelihood[i] += tables->logProbability(question, i, answer);
+	}
+}
+
+void GridPosterior::removeAnswer(size_t question, int answer) {
+	for (size_t i = 0; i < log_likelihood.size(); ++i) {
+		log_likelihood[i] -= tables->logProbability(question, i, answer);
+	}
+}
+
+const std::vector<double> &GridPosterior::getNodes() const {
+	return integrator.getNodes();
+}
+
+const std::vector<double> &GridPosterior::getWeights() const {
+	return integrator.getWeights();
+}
+
+const std::vector<double> &GridPosterior::getLogLikelihood() const {
+	return log_likelihood;
+}
+
+const std::vector<double> &GridPosterior::getLogPrior() const {
+	return log_prior;
+}
+
+const ItemTables &GridPosterior::getTables() const {
+	return *tables;
+}
+
+PosteriorMoments GridPosterior::moments() const {
+	std::vector<double> log_density(log_likelihood.size());
+	for (size_t i = 0; i < log_density.size(); ++i) {
+		log_density[i] = log_likelihood[i] + log_prior[i];
+	}
+	return integrator.moments(log_density);
+}
+
+PosteriorMoments GridPosterior::moments(size_t question, int answer) const {
+	std::vector<double> log_density(log_likelihood.size());
+	for (size_t i = 0; i < log_density.size(); ++i) {
+		log_density[i] = log_likelihood[i] + log_prior[i] + tables->logProbability(question, i, answer);
+	}
+	return integrator.moments(log_density);
+}
+
+double GridPosterior::integrate(const double *values, bool use_prior) const {
+	const std::vector<double> weights = integrationWeights(use_prior);
+	double sum = 0.0;
+	for (size_t i = 0; i < weights.size(); ++i) {
+		sum += weights[i] * values[i];
+	}
+	return sum;
+}
+
+std::vector<double> GridPosterior::integrationWeights(bool use_prior) const {
+	const std::vector<double> &weights = integrator.getWeights();
+	std::vector<double> result(log_likelihood.size());
+	for (size_t i = 0; i < result.size(); ++i) {
+		const double log_density = use_prior ? log_likelihood[i] + log_prior[i] : log_likelihood[i];
+		result[i] = weights[i] * std::exp(log_density);
+	}
+	return result;
+}
+
+std::vector<double> GridPosterior::posteriorMass() const {
+	const std::vector<double> &weights = integrator.getWeights();
+	std::vector<double> mass(log_likelihood.size());
+	for (size_t i = 0; i < mass.size(); ++i) {
+		mass[i] = log_likelihood[i] + log_prior[i];
+	}
+	// scale by the largest ordinate so exp() cannot underflow to an all-zero posterior
+	const double log_max = *std::max_element(mass.begin(), mass.end());
+	for (size_t i = 0; i < mass.size(); ++i) {
+		mass[i] = weights[i] * std::exp(mass[i] - log_max);
+	}
+	return mass;
+}
+
+std::vector<double> GridPosterior::answerVariances(size_t question, const std::vector<double> &mass) const {
+	const std::vector<double> &nodes = integrator.getNodes();
+	const size_t categories = tables->categories(question);
+	const double *probs = tables->probabilities(question);
+
+	std::vector<double> constant(categories, 0.0);
+	std::vector<double> first(categories, 0.0);
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		for (size_t c = 0; c < categories; ++c) {
+			const double answer_mass = mass[i] * probs[i * categories + c];
+			constant[c] += answer_mass;
+			first[c] += answer_mass * nodes[i];
+		}
+	}
+
+	std::vector<double> variances(categories, 0.0);
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		for (size_t c = 0; c < categories; ++c) {
+			const double difference = nodes[i] - first[c] / constant[c];
+			variances[c] += mass[i] * probs[i * categories + c] * difference * difference;
+		}
+	}
+	for (size_t c = 0; c < categories; ++c) {
+		variances[c] /= constant[c];
+	}
+	return variances;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Integrator.h"
+#include "ItemTables.h"
+#include "Prior.h"
+#include "QuestionSet.h"
+
+/**
+ * The log-likelihood of the answered items on the fixed quadrature nodes of a session. Rather than re-multiplying
+ * every answered item at every node, each stored answer adds its log-probability (read from the ItemTables) to
+ * the grid in O(nodes), and a retracted or skipped answer subtracts it again.
+ *
+ * The grid is only active when the Integrator uses a fixed rule; with adaptive quadrature there is no fixed set of
+ * nodes to maintain, and every update is a no-op.
+ */
+class GridPosterior {
+public:
+	GridPosterior(const Integrator &integrator, const Prior &prior);
+
+	bool isActive() const;
+
+	/**
+	 * Attaches the item tables for this grid (shared through the ItemBank) and recomputes the grid from every
+	 * applicable answer in the question set.
+	 */
+	void reset(const QuestionSet &questionSet, std::shared_ptr<const ItemTables> itemTables);
+
+	void addAnswer(size_t question, int answer);
+
+	void removeAnswer(size_t question, int answer);
+
+	const std::vector<double> &getNodes() const;
+
+	const std::vector<double> &getWeights() const;
+
+	const std::vector<double> &getLogLikelihood() const;
+
+	const std::vector<double> &getLogPrior() const;
+
+	const ItemTables &getTables() const;
+
+	/**
+	 * Posterior summaries, optionally with one more hypothetical answer folded in.
+	 */
+	PosteriorMoments moments() const;
+	PosteriorMoments moments(size_t question, int answer) const;
+
+	/**
+	 * The quadrature sum of likelihood (times prior when use_prior is set) times values, one value per node.
+	 */
+	double integrate(const double *values, bool use_prior) const;
+
+	/**
+	 * The factors integrate() multiplies the values by: the quadrature weight times the likelihood (times the
+	 * prior when use_prior is set) at each node. They are the same for every candidate item of a selection round.
+	 */
+	std::vector<double> integrationWeights(bool use_prior) const;
+
+	/**
+	 * The quadrature weight times the posterior density at each node, scaled so the largest density is one.
+	 */
+	std::vector<double> posteriorMass() const;
+
+	/**
+	 * The posterior variance of theta after each possible answer to question, one per category in the order of
+	 * the ItemTables. The posterior after a hypothetical answer is mass (from posteriorMass()) times the item's
+	 * category curve, so no exponentials are taken per category.
+	 */
+	std::vector<double> answerVariances(size_t question, const std::vector<double> &mass) const;
+
+private:
+	const Integrator &integrator;
+	std::shared_ptr<const ItemTables> tables;
+	std::vector<double> log_likelihood;
+	std::vector<double> log_prior;
+};
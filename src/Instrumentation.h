@@ -0,0 +1,29 @@
+#pragma once
+#include <atomic>
+
+/**
+ * Process-wide counters kept by the compiled code and reported to R by catInstrumentation(). They are updated
+ * from RcppParallel workers, so every counter is atomic; increments use relaxed ordering since the counts are
+ * only ever read as totals.
+ */
+namespace instrumentation
+{
+	/**
+	 * Integration workspaces allocated, and integrations that reused a thread's existing workspace instead.
+	 */
+	extern std::atomic<unsigned long> workspaceAllocations;
+	extern std::atomic<unsigned long> workspaceAllocationsAvoided;
+
+	/**
+	 * Session items answered from a precomputed selection, and those selected on demand instead.
+	 */
+	extern std::atomic<unsigned long> precomputedHits;
+	extern std::atomic<unsigned long> precomputedMisses;
+
+	inline void count(std::atomic<unsigned long> &counter)
+	{
+		counter.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void reset();
+}
@@ -2,19 +2,289 @@
 #include <gsl/gsl_integration.h>
 #include <gsl/gsl_errno.h>
 #include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include "Instrumentation.h"
+
+/**
+ * The 61-point Gauss-Kronrod rule of GSL_INTEG_GAUSS61 (QUADPACK's qk61): Kronrod abscissae on [0, 1] with the
+ * 30-point Gauss abscissae at the odd indices and the centre last, the Gauss weights of the odd indices, and the
+ * Kronrod weights.
+ */
+static const double xgk61[31] = {
+	9.994844100504906375713e-1,
+	9.968934840746495402716e-1,
+	9.916309968704045948586e-1,
+	9.836681232797472099700e-1,
+	9.731163225011262683747e-1,
+	9.600218649683075122169e-1,
+	9.443744447485599794158e-1,
+	9.262000474292743258793e-1,
+	9.055733076999077985465e-1,
+	8.825605357920526815431e-1,
+	8.572052335460610989587e-1,
+	8.295657623827683974429e-1,
+	7.997278358218390830137e-1,
+	7.677774321048261949180e-1,
+	7.337900624532268047262e-1,
+	6.978504947933157969323e-1,
+	6.600610641266269613701e-1,
+	6.205261829892428611405e-1,
+	5.793452358263616917560e-1,
+	5.366241481420198992642e-1,
+	4.924804678617785749937e-1,
+	4.470337695380891767806e-1,
+	4.004012548303943925355e-1,
+	3.527047255308781134710e-1,
+	3.040732022736250773727e-1,
+	2.546369261678898464398e-1,
+	2.045251166823098914390e-1,
+	1.538699136085835469638e-1,
+	1.028069379667370301471e-1,
+	5.147184255531769583303e-2,
+	0.0
+};
+
+static const double wg61[15] = {
+	7.968192496166605615466e-3,
+	1.846646831109095914230e-2,
+	2.878470788332336934972e-2,
+	3.879919256962704959680e-2,
+	4.840267283059405290294e-2,
+	5.749315621761906648172e-2,
+	6.597422988218049512813e-2,
+	7.375597473770520626824e-2,
+	8.075589522942021535469e-2,
+	8.689978720108297980239e-2,
+	9.212252223778612871763e-2,
+	9.636873717464425963947e-2,
+	9.959342058679526706278e-2,
+	1.017623897484055045964e-1,
+	1.028526528935588403413e-1
+};
+
+static const double wgk61[31] = {
+	1.389013698677007624552e-3,
+	3.890461127099884051267e-3,
+	6.630703915931292173320e-3,
+	9.273279659517763428441e-3,
+	1.182301525349634174223e-2,
+	1.436972950704580481245e-2,
+	1.692088918905327262757e-2,
+	1.941414119394238117341e-2,
+	2.182803582160919229717e-2,
+	2.419116207808060136569e-2,
+	2.650995488233310161060e-2,
+	2.875404876504129284398e-2,
+	3.090725756238776247288e-2,
+	3.298144705748372603181e-2,
+	3.497933802806002413750e-2,
+	3.688236465182122922391e-2,
+	3.867894562472759295035e-2,
+	4.037453895153595911200e-2,
+	4.196981021516424614715e-2,
+	4.345253970135606931683e-2,
+	4.481480013316266319236e-2,
+	4.605923827100698811627e-2,
+	4.718554656929915394526e-2,
+	4.818586175708712914078e-2,
+	4.905543455502977888753e-2,
+	4.979568342707420635781e-2,
+	5.040592140278234684089e-2,
+	5.088179589874960649230e-2,
+	5.122154784925877217066e-2,
+	5.142612853745902593386e-2,
+	5.149472942945156755834e-2
+};
+
+/**
+ * QUADPACK's error estimate, as in GSL's qk.c.
+ */
+static double rescale_error(double err, const double result_abs, const double result_asc) {
+	err = std::fabs(err);
+	if (result_asc != 0 && err != 0) {
+		double scale = std::pow((200 * err / result_asc), 1.5);
+		err = scale < 1 ? result_asc * scale : result_asc;
+	}
+	if (result_abs > GSL_DBL_MIN / (50 * GSL_DBL_EPSILON)) {
+		double min_err = 50 * GSL_DBL_EPSILON * result_abs;
+		if (min_err > err) {
+			err = min_err;
+		}
+	}
+	return err;
+}
+
+/**
+ * gsl_integration_qk61 over [a, b], with every node evaluated in one call of the batch function. The sums are
+ * accumulated in GSL's order.
+ */
+static void qk61(Integrator::BatchFunction function, const void *params, const double a, const double b,
+                 double *result, double *abserr, double *resabs, double *resasc) {
+	const double center = 0.5 * (a + b);
+	const double half_length = 0.5 * (b - a);
+	const double abs_half_length = std::fabs(half_length);
+
+	// x[0] is the centre; x[2j + 1] and x[2j + 2] are center -+ half_length * xgk61[j]
+	double x[61];
+	double fx[61];
+	x[0] = center;
+	for (size_t j = 0; j < 30; ++j) {
+		const double abscissa = half_length * xgk61[j];
+		x[2 * j + 1] = center - abscissa;
+		x[2 * j + 2] = center + abscissa;
+	}
+	function(x, 61, fx, params);
+
+	const double f_center = fx[0];
+	const double *fv1 = fx + 1;
+	const double *fv2 = fx + 2;
+
+	double result_gauss = 0;
+	double result_kronrod = f_center * wgk61[30];
+	double result_abs = std::fabs(result_kronrod);
+
+	for (size_t j = 0; j < 15; ++j) {
+		const size_t jtw = j * 2 + 1;
+		const double fval1 = fv1[2 * jtw];
+		const double fval2 = fv2[2 * jtw];
+		const double fsum = fval1 + fval2;
+		result_gauss += wg61[j] * fsum;
+		result_kronrod += wgk61[jtw] * fsum;
+		result_abs += wgk61[jtw] * (std::fabs(fval1) + std::fabs(fval2));
+	}
+
+	for (size_t j = 0; j < 15; ++j) {
+		const size_t jtwm1 = j * 2;
+		const double fval1 = fv1[2 * jtwm1];
+		const double fval2 = fv2[2 * jtwm1];
+		result_kronrod += wgk61[jtwm1] * (fval1 + fval2);
+		result_abs += wgk61[jtwm1] * (std::fabs(fval1) + std::fabs(fval2));
+	}
+
+	const double mean = result_kronrod * 0.5;
+	double result_asc = wgk61[30] * std::fabs(f_center - mean);
+	for (size_t j = 0; j < 30; ++j) {
+		result_asc += wgk61[j] * (std::fabs(fv1[2 * j] - mean) + std::fabs(fv2[2 * j] - mean));
+	}
+
+	const double err = (result_kronrod - result_gauss) * half_length;
+	*result = result_kronrod * half_length;
+	*resabs = result_abs * abs_half_length;
+	*resasc = result_asc * abs_half_length;
+	*abserr = rescale_error(err, *resabs, *resasc);
+}
+
+[[noreturn]] static void integration_error(int error_code) {
+	throw std::runtime_error(gsl_strerror(error_code));
+}
+
+/**
+ * One subinterval of integrateBatch's bisection, as GSL keeps them in a gsl_integration_workspace.
+ */
+struct Subinterval {
+	double a, b, result, error;
+};
+
+/**
+ * The scratch space of one adaptive integral: GSL's workspace for integrate() and the subinterval list of
+ * integrateBatch(). Both are allocated once and grown only when more subintervals are requested.
+ */
+struct Workspace {
+	gsl_integration_workspace *gsl;
+	std::vector<Subinterval> subintervals;
+
+	Workspace() : gsl(nullptr) { }
+
+	~Workspace() {
+		if (gsl != nullptr) {
+			gsl_integration_workspace_free(gsl);
+		}
+	}
+};
+
+/**
+ * Workspaces a thread has finished with. Integration runs inside the RcppParallel workers of item selection,
+ * thousands of times per round, so each thread reuses its own workspaces instead of going through malloc and
+ * free on every integral; no locking is needed since a thread only touches its own pool.
+ */
+static thread_local std::vector<std::unique_ptr<Workspace> > idle_workspaces;
+
+/**
+ * Holds a workspace from the thread's pool for the duration of one integral and returns it on destruction,
+ * including when the integrand throws. An integral started from inside an integrand gets a workspace of its own.
+ */
+class WorkspaceLease {
+public:
+	WorkspaceLease() {
+		if (idle_workspaces.empty()) {
+			workspace.reset(new Workspace());
+		} else {
+			workspace = std::move(idle_workspaces.back());
+			idle_workspaces.pop_back();
+		}
+	}
+
+	~WorkspaceLease() {
+		idle_workspaces.push_back(std::move(workspace));
+	}
+
+	gsl_integration_workspace *gsl(const size_t intervals) {
+		if (workspace->gsl != nullptr && workspace->gsl->limit >= intervals) {
+			instrumentation::count(instrumentation::workspaceAllocationsAvoided);
+			return workspace->gsl;
+		}
+
+		if (workspace->gsl != nullptr) {
+			gsl_integration_workspace_free(workspace->gsl);
+		}
+		workspace->gsl = gsl_integration_workspace_alloc(intervals);
+		// Malloc returns a null pointer if there is insufficient memory available
+		// If the workspace allocator returns that null pointer, nothing below
+		// will work - it will rely on dereferencing a null pointer.
+		if (workspace->gsl == nullptr) {
+			// No error message is permitted when throwing bad_alloc,
+			// because it needs to be able to be constructed without
+			// using any additional memory
+			throw std::bad_alloc();
+		}
+		instrumentation::count(instrumentation::workspaceAllocations);
+		return workspace->gsl;
+	}
+
+	std::vector<Subinterval> &subintervals(const size_t intervals) {
+		std::vector<Subinterval> &list = workspace->subintervals;
+		list.clear();
+		if (list.capacity() >= intervals) {
+			instrumentation::count(instrumentation::workspaceAllocationsAvoided);
+		} else {
+			list.reserve(intervals);
+			instrumentation::count(instrumentation::workspaceAllocations);
+		}
+		return list;
+	}
+
+private:
+	std::unique_ptr<Workspace> workspace;
+};
+
+Integrator::Integrator() : quadratureType(QuadratureType::ADAPTIVE) { }
+
+Integrator::Integrator(QuadratureType type, size_t points, double lower, double upper) : quadratureType(type) {
+	if (type == QuadratureType::LEGENDRE) {
+		legendreRule(points, lower, upper);
+	} else if (type == QuadratureType::HERMITE) {
+		hermiteRule(points, lower, upper);
+	} else if (type == QuadratureType::GRID) {
+		gridRule(points, lower, upper);
+	}
+}
 
 double Integrator::integrate(const gsl_function *function, const size_t intervals,
                              const double lower, const double upper) const {
-	gsl_integration_workspace *workspace = gsl_integration_workspace_alloc(intervals);
-	// Malloc returns a null pointer if there is insufficient memory available
-	// If the workspace allocator returns that null pointer, nothing below
-	// will work - it will rely on dereferencing a null pointer.
-	if (workspace == nullptr) {
-		// No error message is permitted when throwing bad_alloc,
-		// because it needs to be able to be constructed without
-		// using any additional memory
-		throw std::bad_alloc();
-	}
+	WorkspaceLease lease;
+	gsl_integration_workspace *workspace = lease.gsl(intervals);
 
 	double result, absolute_error;
 	const int integration_method = GSL_INTEG_GAUSS61;
@@ -25,9 +295,6 @@ double Integrator::integrate(const gsl_function *function, const size_t interval
 	int error_code = gsl_integration_qag(function, lower, upper, relative_error_limit, absolute_error_limit,
 	                                     intervals, integration_method, workspace, &result, &absolute_error);
 
-	// Always ensure that any allocated memory is freed
-	gsl_integration_workspace_free(workspace);
-
 	if (error_code != GSL_SUCCESS) {
 		const char *error_message = gsl_strerror(error_code);
 		throw std::runtime_error(error_message);
@@ -36,3 +303,248 @@ double Integrator::integrate(const gsl_function *function, const size_t interval
 	return result;
 }
 
+double Integrator::integrateBatch(BatchFunction function, const void *params, const size_t intervals,
+                                  const double lower, const double upper) const {
+	// gsl_integration_qag, step for step
+	const double absolute_error_limit = GSL_SQRT_DBL_EPSILON;
+	const double relative_error_limit = GSL_SQRT_DBL_EPSILON;
+
+	double result0, abserr0, resabs0, resasc0;
+	qk61(function, params, lower, upper, &result0, &abserr0, &resabs0, &resasc0);
+
+	double tolerance = std::max(absolute_error_limit, relative_error_limit * std::fabs(result0));
+	const double round_off = 50 * GSL_DBL_EPSILON * resabs0;
+
+	if (abserr0 <= round_off && abserr0 > tolerance) {
+		integration_error(GSL_EROUND);
+	} else if ((abserr0 <= tolerance && abserr0 != resasc0) || abserr0 == 0.0) {
+		return result0;
+	} else if (intervals == 1) {
+		integration_error(GSL_EMAXITER);
+	}
+
+	WorkspaceLease lease;
+	std::vector<Subinterval> &subintervals = lease.subintervals(intervals);
+	subintervals.push_back(Subinterval{lower, upper, result0, abserr0});
+
+	double area = result0;
+	double errsum = abserr0;
+	size_t iteration = 1;
+	int roundoff_type1 = 0, roundoff_type2 = 0, error_type = 0;
+
+	do {
+		// bisect the subinterval with the largest error estimate
+		size_t i = 0;
+		for (size_t k = 1; k < subintervals.size(); ++k) {
+			if (subintervals[k].error > subintervals[i].error) {
+				i = k;
+			}
+		}
+		const Subinterval current = subintervals[i];
+		const double a1 = current.a;
+		const double b1 = 0.5 * (current.a + current.b);
+		const double a2 = b1;
+		const double b2 = current.b;
+
+		double area1, error1, resabs1, resasc1;
+		double area2, error2, resabs2, resasc2;
+		qk61(function, params, a1, b1, &area1, &error1, &resabs1, &resasc1);
+		qk61(function, params, a2, b2, &area2, &error2, &resabs2, &resasc2);
+
+		const double area12 = area1 + area2;
+		const double error12 = error1 + error2;
+
+		errsum += (error12 - current.error);
+		area += area12 - current.result;
+
+		if (resasc1 != error1 && resasc2 != error2) {
+			const double delta = current.result - area12;
+			if (std::fabs(delta) <= 1.0e-5 * std::fabs(area12) && error12 >= 0.99 * current.error) {
+				roundoff_type1++;
+			}
+			if (iteration >= 10 && error12 > current.error) {
+				roundoff_type2++;
+			}
+		}
+
+		tolerance = std::max(absolute_error_limit, relative_error_limit * std::fabs(area));
+
+		if (errsum > tolerance) {
+			if (roundoff_type1 >= 6 || roundoff_type2 >= 20) {
+				error_type = 2;
+			}
+			// bad integrand behaviour at a point of the integration range
+			const double tmp = (1 + 100 * GSL_DBL_EPSILON) * (std::fabs(a2) + 1000 * GSL_DBL_MIN);
+			if (std::fabs(a1) <= tmp && std::fabs(b2) <= tmp) {
+				error_type = 3;
+			}
+		}
+
+		if (error2 > error1) {
+			subintervals[i] = Subinterval{a2, b2, area2, error2};
+			subintervals.push_back(Subinterval{a1, b1, area1, error1});
+		} else {
+			subintervals[i] = Subinterval{a1, b1, area1, error1};
+			subintervals.push_back(Subinterval{a2, b2, area2, error2});
+		}
+		iteration++;
+	} while (iteration < intervals && !error_type && errsum > tolerance);
+
+	double result = 0;
+	for (const Subinterval &subinterval : subintervals) {
+		result += subinterval.result;
+	}
+
+	if (errsum <= tolerance) {
+		return result;
+	} else if (error_type == 2) {
+		integration_error(GSL_EROUND);
+	} else if (error_type == 3) {
+		integration_error(GSL_ESING);
+	} else if (iteration == intervals) {
+		integration_error(GSL_EMAXITER);
+	}
+	integration_error(GSL_EFAILED);
+}
+
+QuadratureType Integrator::getQuadratureType() const {
+	return quadratureType;
+}
+
+bool Integrator::isAdaptive() const {
+	return quadratureType == QuadratureType::ADAPTIVE;
+}
+
+const std::vector<double> &Integrator::getNodes() const {
+	return nodes;
+}
+
+const std::vector<double> &Integrator::getWeights() const {
+	return weights;
+}
+
+PosteriorMoments Integrator::moments(const std::vector<double> &log_density) const {
+	// scale by the largest ordinate so exp() cannot underflow to an all-zero posterior
+	const double log_max = *std::max_element(log_density.begin(), log_density.end());
+
+	double constant = 0.0;
+	double first = 0.0;
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		const double mass = weights[i] * std::exp(log_density[i] - log_max);
+		constant += mass;
+		first += mass * nodes[i];
+	}
+	const double theta = first / constant;
+
+	double second = 0.0;
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		const double difference = nodes[i] - theta;
+		second += weights[i] * std::exp(log_density[i] - log_max) * difference * difference;
+	}
+
+	PosteriorMoments result;
+	result.theta = theta;
+	result.se = std::sqrt(second / constant);
+	result.constant = constant * std::exp(log_max);
+	return result;
+}
+
+QuadratureType Integrator::parseQuadratureType(const std::string &name) {
+	if (name == "ADAPTIVE") {
+		return QuadratureType::ADAPTIVE;
+	}
+	if (name == "LEGENDRE") {
+		return QuadratureType::LEGENDRE;
+	}
+	if (name == "HERMITE") {
+		return QuadratureType::HERMITE;
+	}
+	if (name == "GRID") {
+		return QuadratureType::GRID;
+	}
+	throw std::invalid_argument(name + " is not a valid quadrature type.");
+}
+
+void Integrator::legendreRule(size_t points, double lower, double upper) {
+	gsl_integration_glfixed_table *table = gsl_integration_glfixed_table_alloc(points);
+	if (table == nullptr) {
+		throw std::bad_alloc();
+	}
+
+	nodes.resize(points);
+	weights.resize(points);
+	for (size_t i = 0; i < points; ++i) {
+		gsl_integration_glfixed_point(lower, upper, i, &nodes[i], &weights[i], table);
+	}
+	gsl_integration_glfixed_table_free(table);
+}
+
+/**
+ * Gauss-Hermite nodes from Newton iteration on the orthonormal Hermite recurrence. The rule is shifted to the
+ * midpoint of the bounds and scaled so the outermost nodes fall on them, and each weight absorbs exp(x^2) so the
+ * rule integrates likelihood times prior directly rather than against the Hermite weight function.
+ */
+void Integrator::hermiteRule(size_t points, double lower, double upper) {
+	std::vector<double> x(points, 0.0);
+	std::vector<double> w(points, 0.0);
+
+	const double pim4 = std::pow(M_PI, -0.25);
+	const double n = (double) points;
+	double z = 0.0;
+	for (size_t i = 0; i < (points + 1) / 2; ++i) {
+		// initial guesses for the largest roots, then extrapolation from the previous ones
+		if (i == 0) {
+			z = std::sqrt(2.0 * n + 1.0) - 1.85575 * std::pow(2.0 * n + 1.0, -1.0 / 6.0);
+		} else if (i == 1) {
+			z -= 1.14 * std::pow(n, 0.426) / z;
+		} else if (i == 2) {
+			z = 1.86 * z - 0.86 * x[0];
+		} else if (i == 3) {
+			z = 1.91 * z - 0.91 * x[1];
+		} else {
+			z = 2.0 * z - x[i - 2];
+		}
+
+		double derivative = 0.0;
+		for (int iter = 0; iter < 100; ++iter) {
+			double p1 = pim4;
+			double p2 = 0.0;
+			for (size_t j = 1; j <= points; ++j) {
+				const double p3 = p2;
+				p2 = p1;
+				p1 = z * std::sqrt(2.0 / j) * p2 - std::sqrt((j - 1.0) / j) * p3;
+			}
+			derivative = std::sqrt(2.0 * n) * p2;
+			const double z_old = z;
+			z = z_old - p1 / derivative;
+			if (std::abs(z - z_old) <= 1e-14 * std::max(1.0, std::abs(z))) {
+				break;
+			}
+		}
+
+		x[i] = z;
+		x[points - 1 - i] = -z;
+		w[i] = 2.0 / (derivative * derivative);
+		w[points - 1 - i] = w[i];
+	}
+
+	const double center = (lower + upper) / 2.0;
+	const double scale = points == 1 ? 0.0 : ((upper - lower) / 2.0) / x[0];
+
+	nodes.resize(points);
+	weights.resize(points);
+	for (size_t i = 0; i < points; ++i) {
+		nodes[i] = center + scale * x[points - 1 - i];
+		weights[i] = scale * w[points - 1 - i] * std::exp(x[i] * x[i]);
+	}
+}
+
+void Integrator::gridRule(size_t points, double lower, double upper) {
+	const double step = (upper - lower) / (points - 1.0);
+
+	nodes.resize(points);
+	weights.assign(points, step);
+	for (size_t i = 0; i < points; ++i) {
+		nodes[i] = lower + i * step;
+	}
+}
@@ -0,0 +1,127 @@
+#include "ItemBank.h"
+#include "QuestionSet.h"
+#include <algorithm>
+#include <stdexcept>
+
+static std::vector<std::string> read_names(Rcpp::S4 &cat_df) {
+	Rcpp::NumericVector discrim_names = cat_df.slot("discrimination");
+	Rcpp::CharacterVector names = discrim_names.names();
+	return Rcpp::as<std::vector<std::string> >(names);
+}
+
+static ThresholdTable read_difficulty(Rcpp::S4 &cat_df) {
+	Rcpp::List items = cat_df.slot("difficulty");
+	ThresholdTable difficulty;
+	difficulty.offsets.reserve(items.size() + 1);
+	difficulty.offsets.push_back(0);
+	for (int i = 0; i < items.size(); ++i) {
+		Rcpp::NumericVector thresholds = items[i];
+		difficulty.values.insert(difficulty.values.end(), thresholds.begin(), thresholds.end());
+		difficulty.offsets.push_back(difficulty.values.size());
+	}
+	return difficulty;
+}
+
+static ModelType read_model_type(const std::string &model) {
+	if (model == "ltm") {
+		return ModelType::LTM;
+	}
+	if (model == "tpm") {
+		return ModelType::TPM;
+	}
+	if (model == "grm") {
+		return ModelType::GRM;
+	}
+	if (model == "gpcm") {
+		return ModelType::GPCM;
+	}
+	Rcpp::stop("%s is not a valid model.", model);
+}
+
+static std::vector<size_t> count_categories(const ThresholdTable &difficulty, ModelType modelType) {
+	std::vector<size_t> categories(difficulty.size());
+	for (size_t i = 0; i < categories.size(); ++i) {
+		categories[i] = ((modelType == ModelType::LTM) | (modelType == ModelType::TPM)) ? 2 : difficulty.at(i).size() + 1;
+	}
+	return categories;
+}
+
+double ThresholdSpan::at(size_t i) const {
+	if (i >= count) {
+		throw std::out_of_range("ThresholdSpan::at");
+	}
+	return first[i];
+}
+
+ThresholdSpan ThresholdTable::at(size_t item) const {
+	if (item >= size()) {
+		throw std::out_of_range("ThresholdTable::at");
+	}
+	return (*this)[item];
+}
+
+ItemBank::ItemBank(Rcpp::S4 &cat_df) : question_names(read_names(cat_df)),
+                                       difficulty(read_difficulty(cat_df)),
+                                       guessing(Rcpp::as<std::vector<double> >(cat_df.slot("guessing"))),
+                                       discrimination(Rcpp::as<std::vector<double> >(cat_df.slot("discrimination"))),
+                                       model(Rcpp::as<std::string>(cat_df.slot("model"))),
+                                       modelType(read_model_type(model)),
+                                       categories(count_categories(difficulty, modelType)) { }
+
+size_t ItemBank::size() const {
+	return discrimination.size();
+}
+
+std::shared_ptr<const ItemTables> ItemBank::tables(const std::vector<double> &nodes,
+                                                   const QuestionSet &questionSet) const {
+	std::lock_guard<std::mutex> lock(tables_mutex);
+	for (auto &cached : cached_tables) {
+		if (cached->getNodes() == nodes) {
+			return cached;
+		}
+	}
+
+	std::shared_ptr<ItemTables> built = std::make_shared<ItemTables>();
+	built->build(questionSet, nodes);
+	cached_tables.push_back(built);
+	return built;
+}
+
+std::shared_ptr<const MFIIndex> ItemBank::mfiIndex(double lower, double upper, size_t cells, Estimator &estimator,
+                                                  const QuestionSet &questionSet) const {
+	std::lock_guard<std::mutex> lock(tables_mutex);
+	for (auto &cached : cached_indexes) {
+		if (cached->matches(lower, upper, cells)) {
+			return cached;
+		}
+	}
+
+	std::shared_ptr<MFIIndex> built = std::make_shared<MFIIndex>();
+	built->build(estimator, questionSet, lower, upper, cells);
+	cached_indexes.push_back(built);
+	return built;
+}
+
+bool ItemBank::matches(Rcpp::S4 &cat_df) const {
+	// compare against views of the slots rather than copies
+	Rcpp::NumericVector discrim = cat_df.slot("discrimination");
+	Rcpp::NumericVector guess = cat_df.slot("guessing");
+	Rcpp::List diff = cat_df.slot("difficulty");
+
+	if (model != Rcpp::as<std::string>(cat_df.slot("model")) || (size_t) discrim.size() != size() ||
+	    (size_t) guess.size() != size() || (size_t) diff.size() != size()) {
+		return false;
+	}
+	if (!std::equal(discrim.begin(), discrim.end(), discrimination.begin()) ||
+	    !std::equal(guess.begin(), guess.end(), guessing.begin())) {
+		return false;
+	}
+	for (size_t i = 0; i < size(); ++i) {
+		Rcpp::NumericVector item = diff[i];
+		if ((size_t) item.size() != difficulty[i].size() ||
+		    !std::equal(item.begin(), item.end(), difficulty[i].begin())) {
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <Rcpp.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ItemTables.h"
+#include "MFIIndex.h"
+#include "ModelPolicy.h"
+
+class Estimator;
+struct QuestionSet;
+
+/**
+ * A read-only view of one item's thresholds inside a ThresholdTable.
+ */
+struct ThresholdSpan {
+	const double *first;
+	size_t count;
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	const double *begin() const { return first; }
+	const double *end() const { return first + count; }
+	double operator[](size_t i) const { return first[i]; }
+	double at(size_t i) const;
+};
+
+/**
+ * The difficulty/threshold parameters of every item, stored back to back in one array (CSR layout): item j's
+ * thresholds are values[offsets[j]] up to values[offsets[j + 1]]. Compared to one heap allocation per item, the
+ * probability kernels walk a single contiguous block for the whole bank.
+ */
+struct ThresholdTable {
+	std::vector<double> values;
+	std::vector<size_t> offsets;
+
+	size_t size() const { return offsets.size() - 1; }
+	ThresholdSpan operator[](size_t item) const { return ThresholdSpan{values.data() + offsets[item], offsets[item + 1] - offsets[item]}; }
+	ThresholdSpan at(size_t item) const;
+};
+
+/**
+ * The item parameters of a Cat: everything that is fixed for the life of a bank, as opposed to the per-respondent
+ * answers held by QuestionSet. An ItemBank is immutable once built and is held through a shared_ptr, so any number
+ * of sessions (and the worker threads they start) can share one copy of the parameters.
+ *
+ * The only mutable parts are the caches of ItemTables, one per quadrature grid, and of MFIIndexes, one per theta
+ * resolution, which are guarded by a mutex.
+ */
+class ItemBank {
+public:
+	ItemBank(Rcpp::S4 &cat_df);
+
+	const std::vector<std::string> question_names;
+	const ThresholdTable difficulty;
+	const std::vector<double> guessing;
+	const std::vector<double> discrimination;
+	const std::string model;
+	/**
+	 * The model, parsed once so that the estimators can choose their kernels without comparing strings.
+	 */
+	const ModelType modelType;
+	/**
+	 * Number of response categories of each item (2 for ltm/tpm, thresholds + 1 for grm/gpcm).
+	 */
+	const std::vector<size_t> categories;
+
+	size_t size() const;
+
+	/**
+	 * Returns the probability and information tables for the given grid, building them on first use. The question
+	 * set is only used to read the item parameters, which depend on the bank alone.
+	 */
+	std::shared_ptr<const ItemTables> tables(const std::vector<double> &nodes, const QuestionSet &questionSet) const;
+
+	/**
+	 * Returns the MFI ranking index with the given number of cells over lower to upper, building it on first use.
+	 */
+	std::shared_ptr<const MFIIndex> mfiIndex(double lower, double upper, size_t cells, Estimator &estimator,
+	                                         const QuestionSet &questionSet) const;
+
+	/**
+	 * Whether the item parameters of cat_df are those of this bank.
+	 */
+	bool matches(Rcpp::S4 &cat_df) const;
+
+private:
+	mutable std::mutex tables_mutex;
+	mutable std::vector<std::shared_ptr<const ItemTables> > cached_tables;
+	mutable std::vector<std::shared_ptr<const MFIIndex> > cached_indexes;
+};
@@ -0,0 +1,191 @@
+#include "ItemTables.h"
+#include "QuestionSet.h"
+#include "ProbabilityKernels.h"
+#include <algorithm>
+#include <cmath>
+
+ItemTables::ItemTables() : nodes(0), lowest_response(0) { }
+
+void ItemTables::build(const QuestionSet &questionSet, const std::vector<double> &points) {
+	const size_t items = questionSet.answers.size();
+	grid = points;
+	nodes = grid.size();
+	lowest_response = ((questionSet.modelType == ModelType::LTM) | (questionSet.modelType == ModelType::TPM)) ? 0 : 1;
+
+	offsets.resize(items);
+	category_counts.resize(items);
+	size_t total = 0;
+	for (size_t j = 0; j < items; ++j) {
+		category_counts[j] = questionSet.bank->categories[j];
+		offsets[j] = total;
+		total += category_counts[j] * nodes;
+	}
+
+	probability_table.resize(total);
+	log_probability_table.resize(total);
+	information_table.resize(items * nodes);
+
+	if (lowest_response == 0) {
+		build_binary(questionSet);
+	} else {
+		build_polytomous(questionSet);
+	}
+}
+
+void ItemTables::build_binary(const QuestionSet &questionSet) {
+	std::vector<double> P(nodes);
+	for (size_t j = 0; j < category_counts.size(); ++j) {
+		const double discrimination = questionSet.discrimination[j];
+		const double guessing = questionSet.guessing[j];
+		kernels::ltm_probability(grid.data(), nodes, questionSet.difficulty[j][0], discrimination, guessing, P.data());
+
+		double *row = &probability_table[offsets[j]];
+		double *log_row = &log_probability_table[offsets[j]];
+		for (size_t i = 0; i < nodes; ++i) {
+			row[2 * i] = 1.0 - P[i];
+			row[2 * i + 1] = P[i];
+			log_row[2 * i] = std::log(1.0 - P[i]);
+			log_row[2 * i + 1] = std::log(P[i]);
+
+			// Estimator::obsInf_ltm
+			const double temp = (P[i] - guessing) / (1.0 - guessing);
+			information_table[j * nodes + i] = discrimination * discrimination * temp * temp * ((1.0 - P[i]) / P[i]);
+		}
+	}
+}
+
+void ItemTables::build_polytomous(const QuestionSet &questionSet) {
+	const bool graded = questionSet.modelType == ModelType::GRM;
+	std::vector<double> cumulative;
+	std::vector<double> scores;
+	for (size_t j = 0; j < category_counts.size(); ++j) {
+		const size_t categories = category_counts[j];
+		const double discrimination = questionSet.discrimination[j];
+		const ThresholdSpan thresholds = questionSet.difficulty[j];
+		cumulative.assign(categories + 1, 0.0);
+		scores.resize(categories);
+
+		for (size_t i = 0; i < nodes; ++i) {
+			double *row = &probability_table[offsets[j] + i * categories];
+			double *log_row = &log_probability_table[offsets[j] + i * categories];
+			double information = 0.0;
+
+			if (graded) {
+				// Estimator::prob_grm and fisherInf, except that boundaries clamped to the same value leave their
+				// category with probability eps instead of failing
+				kernels::grm_boundaries(grid[i], discrimination, thresholds.begin(), thresholds.size(), &cumulative[1]);
+				cumulative[categories] = 1.0;
+				for (size_t c = 0; c < categories; ++c) {
+					row[c] = std::max(cumulative[c + 1] - cumulative[c], kernels::eps);
+					const double w1 = cumulative[c + 1] * (1.0 - cumulative[c + 1]);
+					const double w2 = cumulative[c] * (1.0 - cumulative[c]);
+					information += (w1 - w2) * (w1 - w2) / row[c];
+				}
+				information *= discrimination * discrimination;
+			} else {
+				// Estimator::prob_gpcm with the exponents shifted by their maximum so the sum cannot overflow; the
+				// information of a partial credit item is discrimination^2 times the variance of the category
+				scores[0] = discrimination * grid[i];
+				for (size_t c = 1; c < categories; ++c) {
+					scores[c] = scores[c - 1] + discrimination * (grid[i] - thresholds[c - 1]);
+				}
+				const double shift = *std::max_element(scores.begin(), scores.end());
+				double denominator = 0.0;
+				for (size_t c = 0; c < categories; ++c) {
+					row[c] = std::exp(scores[c] - shift);
+					denominator += row[c];
+				}
+				double mean = 0.0, square = 0.0;
+				for (size_t c = 0; c < categories; ++c) {
+					row[c] /= denominator;
+					mean += c * row[c];
+					square += c * c * row[c];
+				}
+				information = discrimination * discrimination * (square - mean * mean);
+			}
+
+			for (size_t c = 0; c < categories; ++c) {
+				log_row[c] = std::log(row[c]);
+			}
+			information_table[j * nodes + i] = information;
+		}
+	}
+}
+
+bool ItemTables::empty() const {
+	return nodes == 0;
+}
+
+size_t ItemTables::nodeCount() const {
+	return nodes;
+}
+
+const std::vector<double> &ItemTables::getNodes() const {
+	return grid;
+}
+
+size_t ItemTables::categories(size_t question) const {
+	return category_counts[question];
+}
+
+const double *ItemTables::probabilities(size_t question) const {
+	return &probability_table[offsets[question]];
+}
+
+const double *ItemTables::logProbabilities(size_t question) const {
+	return &log_probability_table[offsets[question]];
+}
+
+const double *ItemTables::information(size_t question) const {
+	return &information_table[question * nodes];
+}
+
+double ItemTables::logProbability(size_t question, size_t node, int answer) const {
+	return log_probability_table[offsets[question] + node * category_counts[question] + (answer - lowest_response)];
+}
+
+void ItemTables::informationProduct(const std::vector<int> &items, const double *weights, double *out) const {
+	size_t k = 0;
+	for (; k + 4 <= items.size(); k += 4) {
+		const double *row0 = information(items[k]);
+		const double *row1 = information(items[k + 1]);
+		const double *row2 = information(items[k + 2]);
+		const double *row3 = information(items[k + 3]);
+		double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sum3 = 0.0;
+		for (size_t i = 0; i < nodes; ++i) {
+			const double weight = weights[i];
+			sum0 += weight * row0[i];
+			sum1 += weight * row1[i];
+			sum2 += weight * row2[i];
+			sum3 += weight * row3[i];
+		}
+		out[k] = sum0;
+		out[k + 1] = sum1;
+		out[k + 2] = sum2;
+		out[k + 3] = sum3;
+	}
+	for (; k < items.size(); ++k) {
+		const double *row = information(items[k]);
+		double sum = 0.0;
+		for (size_t i = 0; i < nodes; ++i) {
+			sum += weights[i] * row[i];
+		}
+		out[k] = sum;
+	}
+}
+
+std::vector<double> ItemTables::categoryProbabilities(const std::vector<double> &probability, ModelType modelType) {
+	std::vector<double> categories;
+	if ((modelType == ModelType::LTM) | (modelType == ModelType::TPM)) {
+		categories.push_back(1.0 - probability.at(0));
+		categories.push_back(probability.at(0));
+	} else if (modelType == ModelType::GRM) {
+		categories.reserve(probability.size() - 1);
+		for (size_t i = 1; i < probability.size(); ++i) {
+			categories.push_back(probability[i] - probability[i - 1]);
+		}
+	} else {
+		categories = probability;
+	}
+	return categories;
+}
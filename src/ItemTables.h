@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "ModelPolicy.h"
+
+struct QuestionSet;
+
+/**
+ * Category probabilities and Fisher information of every item at every node of a fixed quadrature grid. Item
+ * parameters do not change over the life of a bank, so these are computed once and afterwards every per-node
+ * evaluation made during estimation and selection is a lookup.
+ *
+ * Each item's probabilities are stored node-major in one contiguous array: the probability of category c at
+ * node i is at offset(item) + i * categories(item) + c. Categories are indexed from the lowest response
+ * (0 for ltm/tpm, 1 for grm/gpcm).
+ */
+class ItemTables {
+public:
+	ItemTables();
+
+	void build(const QuestionSet &questionSet, const std::vector<double> &nodes);
+
+	bool empty() const;
+
+	size_t nodeCount() const;
+
+	const std::vector<double> &getNodes() const;
+
+	size_t categories(size_t question) const;
+
+	const double *probabilities(size_t question) const;
+
+	const double *logProbabilities(size_t question) const;
+
+	const double *information(size_t question) const;
+
+	double logProbability(size_t question, size_t node, int answer) const;
+
+	/**
+	 * out[k] = the sum over nodes of information(items[k])[i] * weights[i]: the information rows of the listed
+	 * items times one weight vector. Rows are taken four at a time so each weight is loaded once per block.
+	 */
+	void informationProduct(const std::vector<int> &items, const double *weights, double *out) const;
+
+	/**
+	 * Converts the output of Estimator::probability (P(1) for binary models, cumulative probabilities for grm)
+	 * into one probability per response category.
+	 */
+	static std::vector<double> categoryProbabilities(const std::vector<double> &probability, ModelType modelType);
+
+private:
+	/**
+	 * ltm/tpm tables, filled with the batch logistic kernel over all nodes of an item at once.
+	 */
+	void build_binary(const QuestionSet &questionSet);
+
+	/**
+	 * grm/gpcm tables. They are computed so as never to fail: every item of the bank is tabulated at every node,
+	 * including steep items no respondent may answer, and a category whose probability underflows is floored at
+	 * eps rather than rejected as Estimator::prob_grm and prob_gpcm would.
+	 */
+	void build_polytomous(const QuestionSet &questionSet);
+
+	size_t nodes;
+	std::vector<double> grid;
+	int lowest_response;
+	std::vector<size_t> offsets;
+	std::vector<size_t> category_counts;
+	std::vector<double> probability_table;
+	std::vector<double> log_probability_table;
+	std::vector<double> information_table;
+};
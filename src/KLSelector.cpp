@@ -2,11 +2,11 @@
 #include "ParallelUtil.h"
 
 
-struct ExpectedKL : public mpl::FunctionCaller<Prior>
+struct ExpectedKL : public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<Prior>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	ExpectedKL(Estimator& e, Prior& p):Base{e,p}{}
+	ExpectedKL(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
@@ -26,16 +26,19 @@ Selection KLSelector::selectItem() {
   
 	Selection selection;
 	selection.name = "KL";
-	selection.questions = questionSet.nonapplicable_rows;
 
+	const SelectionContext context = estimator.selectionContext(prior, SelectionContext::TEST_INFO);
+	selection.questions = candidates(context.theta, selection);
+
+	prioritize(context, selection);
 	selection.values.resize(selection.questions.size());
 
 	//auto func = [&](int question){return this->estimator.expectedKL(question, prior);};
 	//std::transform(selection.questions.begin(),selection.questions.end(),selection.values.begin(), func);
 
-	mpl::ParallelHelper<ExpectedKL> helper(selection.questions, selection.values, estimator, prior);
-   	// call parallelFor to do the work
-  	RcppParallel::parallelFor(0, selection.questions.size(), helper);
+	mpl::ParallelHelper<ExpectedKL> helper(selection.questions, selection.values, estimator, context);
+   	// call score to do the work
+  	score(selection, helper);
 
 	auto max_itr = std::max_element(selection.values.begin(), selection.values.end());
 	selection.item = selection.questions.at(std::distance(selection.values.begin(),max_itr));
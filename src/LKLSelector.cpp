@@ -2,11 +2,11 @@
 #include "ParallelUtil.h"
 
 
-struct LikelihoodKL : public mpl::FunctionCaller<Prior>
+struct LikelihoodKL : public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<Prior>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	LikelihoodKL(Estimator& e, Prior& p):Base{e,p}{}
+	LikelihoodKL(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
@@ -21,13 +21,16 @@ SelectionType LKLSelector::getSelectionType() {
 Selection LKLSelector::selectItem() {
 	Selection selection;
 	selection.name = "LKL";
-	selection.questions = questionSet.nonapplicable_rows;
 
+	const SelectionContext context = estimator.selectionContext(prior, SelectionContext::THETA | SelectionContext::LIKELIHOOD_WEIGHTS);
+	selection.questions = candidates(context.theta, selection);
+
+	prioritize(context, selection);
 	selection.values.resize(selection.questions.size());
 
-	mpl::ParallelHelper<LikelihoodKL> helper(selection.questions, selection.values, estimator, prior);
-   	// call parallelFor to do the work
-  	RcppParallel::parallelFor(0, selection.questions.size(), helper);
+	mpl::ParallelHelper<LikelihoodKL> helper(selection.questions, selection.values, estimator, context);
+   	// call score to do the work
+  	score(selection, helper);
 
 	auto max_itr = std::max_element(selection.values.begin(), selection.values.end());
 	selection.item = selection.questions.at(std::distance(selection.values.begin(),max_itr));
@@ -0,0 +1,107 @@
+#include <Rcpp.h>
+#include <RcppParallel.h>
+#include <algorithm>
+#include <limits>
+#include "LookAheadSearch.h"
+#include "ItemTables.h"
+#include "ParallelUtil.h"
+
+/**
+ * Scores each candidate at the Cat's answers, searching its subtree sequentially.
+ */
+struct LookAheadSearch::Scoring : public RcppParallel::Worker
+{
+	LookAheadSearch &search;
+	const std::vector<int> &candidates;
+	std::vector<double> &values;
+	mpl::WorkerStatus status;
+
+	Scoring(LookAheadSearch &search, const std::vector<int> &candidates, std::vector<double> &values)
+		: search(search)
+		, candidates(candidates)
+		, values(values)
+		{}
+
+	void operator()(std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end && !status.failed(); ++i) {
+			status.run([&]() {
+				values[i] = search.expectedSE(nullptr, *search.cat.estimator, candidates[i], search.depth, 1.0);
+			});
+		}
+	}
+};
+
+LookAheadSearch::LookAheadSearch(Cat &cat, size_t depth, double tolerance) : cat(cat), depth(depth),
+                                                                             tolerance(tolerance), expanded(0),
+                                                                             pruned(0) { }
+
+Selection LookAheadSearch::selectItem() {
+	Selection selection;
+	selection.name = "LOOKAHEAD";
+	const double theta = cat.estimator->estimateTheta(cat.prior);
+	selection.questions = cat.selector->candidates(theta, selection);
+	selection.values.resize(selection.questions.size());
+
+	Scoring scoring(*this, selection.questions, selection.values);
+	mpl::parallelFor(0, selection.questions.size(), scoring);
+
+	for (int item : selection.questions) {
+		selection.question_names.push_back(cat.questionSet.question_names.at(item));
+	}
+	const auto best = std::min_element(selection.values.begin(), selection.values.end());
+	selection.item = selection.questions.at(best - selection.values.begin());
+	return selection;
+}
+
+size_t LookAheadSearch::getExpanded() const {
+	return expanded.load();
+}
+
+size_t LookAheadSearch::getPruned() const {
+	return pruned.load();
+}
+
+double LookAheadSearch::expectedSE(const Cat::Branch *state, Estimator &estimator, int item, size_t remaining,
+                                   double mass) {
+	const double theta = estimator.estimateTheta(cat.prior);
+	const std::vector<double> probabilities = ItemTables::categoryProbabilities(estimator.probability(theta, item),
+	                                                                            cat.questionSet.modelType);
+	// the first response option is the skip, which carries no probability
+	const std::vector<int> answers = cat.responseOptions(item);
+
+	double sum = 0.0;
+	for (size_t c = 0; c < probabilities.size(); ++c) {
+		const int answer = answers.at(c + 1);
+		const double se = estimator.estimateSE(cat.prior, item, answer);
+		if (remaining == 1) {
+			sum += probabilities[c] * se;
+			continue;
+		}
+		if (mass * probabilities[c] * se < tolerance) {
+			++pruned;
+			sum += probabilities[c] * se;
+			continue;
+		}
+
+		std::unique_ptr<Cat::Branch> branch(state == nullptr ? new Cat::Branch(cat, item, answer)
+		                                                     : new Cat::Branch(cat, *state, item, answer));
+		sum += probabilities[c] * optimalSE(*branch, remaining - 1, mass * probabilities[c]);
+	}
+	return sum;
+}
+
+double LookAheadSearch::optimalSE(Cat::Branch &branch, size_t remaining, double mass) {
+	if (branch.questionSet.nonapplicable_rows.empty()) {
+		return branch.estimator->estimateSE(cat.prior);
+	}
+	++expanded;
+
+	Selection screening;
+	const double theta = branch.estimator->estimateTheta(cat.prior);
+	double best = std::numeric_limits<double>::infinity();
+	for (int item : branch.selector->candidates(theta, screening)) {
+		best = std::min(best, expectedSE(&branch, *branch.estimator, item, remaining, mass));
+	}
+	return best;
+}
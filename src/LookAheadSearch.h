@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include "Cat.h"
+#include "Selection.h"
+
+/**
+ * Multi-step lookahead selection. Each candidate item is scored by the standard error expected after `depth` more
+ * items, the candidate first and the rest chosen to minimize the same objective, with the responses to every item
+ * weighted by their probability at the estimate of theta on their branch:
+ *
+ *   V(state, 0) = SE(state),  V(state, d) = min over items j of  sum over answers r of  P(r | j) V(state + (j, r), d - 1)
+ *
+ * A response branch reached with probability mass m can lower the objective by at most m times its standard
+ * error, since the value searched is never negative. Branches for which that bound is below the tolerance are not
+ * searched further and are scored by their standard error, as at the last step. The bound says nothing about how
+ * much searching could raise the score, and MLE, WLE, and MAP standard errors can grow with further answers, so with
+ * those estimators a pruned branch may be scored below what the full search would give it. The
+ * candidates at the Cat's answers are scored in parallel, each subtree on its own worker; items at every level are
+ * screened as the selectors screen them.
+ */
+class LookAheadSearch {
+public:
+	LookAheadSearch(Cat &cat, size_t depth, double tolerance);
+
+	Selection selectItem();
+
+	/**
+	 * Branches below the candidates at which the next item was searched, and branches cut by the tolerance.
+	 */
+	size_t getExpanded() const;
+	size_t getPruned() const;
+
+private:
+	struct Scoring;
+
+	Cat &cat;
+	const size_t depth;
+	const double tolerance;
+	std::atomic<size_t> expanded;
+	std::atomic<size_t> pruned;
+
+	/**
+	 * The expected standard error after answering item and then remaining - 1 more items, at the Cat's answers
+	 * (state null) or at a branch, reached with probability mass.
+	 */
+	double expectedSE(const Cat::Branch *state, Estimator &estimator, int item, size_t remaining, double mass);
+
+	/**
+	 * The smallest expected standard error after remaining more items at branch.
+	 */
+	double optimalSE(Cat::Branch &branch, size_t remaining, double mass);
+};
@@ -1,6 +1,7 @@
 #include <Rcpp.h>
 using namespace Rcpp;
 #include "MAPEstimator.h"
+#include "Warnings.h"
 
 double MAPEstimator::newton_raphson(Prior prior, double theta_hat_old, double theta_hat_new, bool second_try){
 
@@ -26,7 +27,7 @@ double MAPEstimator::newton_raphson(Prior prior, double theta_hat_old, double th
     
     // write a warning if the second time around we reach max number of iterations
     if(second_try && iter == max_iter){
-        Rcpp::Rcout << "Warning: Newton Raphson algorithm reached maximum number of iterations before theta estimate converged." << std::endl;
+        warnings::warn("Warning: Newton Raphson algorithm reached maximum number of iterations before theta estimate converged.");
     }
     
     return theta_hat_new;
@@ -53,7 +54,7 @@ double MAPEstimator::newton_raphson(Prior prior, size_t question, int answer, do
     }
     
     if(second_try && iter == max_iter){
-        Rcpp::Rcout << "Warning: Newton Raphson algorithm reached maximum number of iterations before theta estimate converged." << std::endl;
+        warnings::warn("Warning: Newton Raphson algorithm reached maximum number of iterations before theta estimate converged.");
     }
     
     return theta_hat_new;
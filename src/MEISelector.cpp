@@ -1,11 +1,11 @@
 #include "MEISelector.h"
 #include "ParallelUtil.h"
 
-struct EObsInf_grm : public mpl::FunctionCaller<Prior>
+struct EObsInf_grm : public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<Prior>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	EObsInf_grm(Estimator& e, Prior& p):Base{e,p}{}
+	EObsInf_grm(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
@@ -13,11 +13,11 @@ struct EObsInf_grm : public mpl::FunctionCaller<Prior>
 	}
 };
 
-struct EObsInf_gpcm: public mpl::FunctionCaller<Prior>
+struct EObsInf_gpcm: public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<Prior>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	EObsInf_gpcm(Estimator& e, Prior& p):Base{e,p}{}
+	EObsInf_gpcm(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
@@ -25,11 +25,11 @@ struct EObsInf_gpcm: public mpl::FunctionCaller<Prior>
 	}
 };
 
-struct EObsInf_rest: public mpl::FunctionCaller<Prior>
+struct EObsInf_rest: public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<Prior>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	EObsInf_rest(Estimator& e, Prior& p):Base{e,p}{}
+	EObsInf_rest(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
@@ -47,30 +47,32 @@ SelectionType MEISelector::getSelectionType() {
 
 Selection MEISelector::selectItem() {
 	Selection selection;
-	selection.questions = questionSet.nonapplicable_rows;
-	selection.values.reserve(questionSet.nonapplicable_rows.size());
 	selection.name = "MEI";
 
+	const SelectionContext context = estimator.selectionContext(prior, SelectionContext::THETA);
+	selection.questions = candidates(context.theta, selection);
+
+	prioritize(context, selection);
 	selection.values.resize(selection.questions.size());
 
-	if(questionSet.model == "grm")
+	if(questionSet.modelType == ModelType::GRM)
 	{
-		mpl::ParallelHelper<EObsInf_grm> helper(selection.questions, selection.values, estimator, prior);
-   		// call parallelFor to do the work
-  		RcppParallel::parallelFor(0, selection.questions.size(), helper);
+		mpl::ParallelHelper<EObsInf_grm> helper(selection.questions, selection.values, estimator, context);
+   		// call score to do the work
+  		score(selection, helper);
 	}
-	else if(questionSet.model == "gpcm")
+	else if(questionSet.modelType == ModelType::GPCM)
 	{
-		mpl::ParallelHelper<EObsInf_gpcm> helper(selection.questions, selection.values, estimator, prior);
-   		// call parallelFor to do the work
-  		RcppParallel::parallelFor(0, selection.questions.size(), helper);
+		mpl::ParallelHelper<EObsInf_gpcm> helper(selection.questions, selection.values, estimator, context);
+   		// call score to do the work
+  		score(selection, helper);
 
 	}
 	else
 	{
-		mpl::ParallelHelper<EObsInf_rest> helper(selection.questions, selection.values, estimator, prior);
-   		// call parallelFor to do the work
-  		RcppParallel::parallelFor(0, selection.questions.size(), helper);
+		mpl::ParallelHelper<EObsInf_rest> helper(selection.questions, selection.values, estimator, context);
+   		// call score to do the work
+  		score(selection, helper);
 	}
 
 	auto max_itr = std::max_element(selection.values.begin(), selection.values.end());
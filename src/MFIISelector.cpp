@@ -1,11 +1,11 @@
 #include "MFIISelector.h"
 #include "ParallelUtil.h"
 
-struct MFII : public mpl::FunctionCaller<Prior>
+struct MFII : public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<Prior>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	MFII(Estimator& e, Prior& p):Base{e,p}{}
+	MFII(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
@@ -25,14 +25,17 @@ Selection MFIISelector::selectItem() {
 	}
   	
 	Selection selection;
-	selection.questions = questionSet.nonapplicable_rows;
 	selection.name = "MFII";
 
+	const SelectionContext context = estimator.selectionContext(prior, SelectionContext::TEST_INFO);
+	selection.questions = candidates(context.theta, selection);
+
+	prioritize(context, selection);
 	selection.values.resize(selection.questions.size());
 
-	mpl::ParallelHelper<MFII> helper(selection.questions, selection.values, estimator, prior);
-   	// call parallelFor to do the work
-  	RcppParallel::parallelFor(0, selection.questions.size(), helper);
+	mpl::ParallelHelper<MFII> helper(selection.questions, selection.values, estimator, context);
+   	// call score to do the work
+  	score(selection, helper);
 
 	auto max_itr = std::max_element(selection.values.begin(), selection.values.end());
 	selection.item = selection.questions.at(std::distance(selection.values.begin(),max_itr));
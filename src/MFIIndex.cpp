@@ -0,0 +1,133 @@
+#include "MFIIndex.h"
+#include "Estimator.h"
+#include "QuestionSet.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+/**
+ * grm and gpcm information is evaluated at points no further apart than this (and at least eight per cell) when
+ * the bounds are built.
+ */
+static const double sample_spacing = 0.02;
+
+/**
+ * Every bound is widened by this relative amount, so rounding in the exact scores cannot cross it.
+ */
+static const double relative_slack = 1e-9;
+
+MFIIndex::MFIIndex() : lower(0.0), upper(0.0), cells(0), items(0) { }
+
+void MFIIndex::build(Estimator &estimator, const QuestionSet &questionSet, double lowerBound, double upperBound,
+                     size_t cellCount) {
+	lower = lowerBound;
+	upper = upperBound;
+	cells = cellCount;
+	items = questionSet.answers.size();
+
+	std::vector<std::vector<double> > bounds(items);
+	for (size_t j = 0; j < items; ++j) {
+		bounds[j] = cell_bounds(estimator, questionSet, (int) j);
+	}
+
+	ranked_items.resize(cells * items);
+	ranked_bounds.resize(cells * items);
+	std::vector<int> order(items);
+	for (size_t c = 0; c < cells; ++c) {
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return bounds[a][c] > bounds[b][c]; });
+		for (size_t k = 0; k < items; ++k) {
+			ranked_items[c * items + k] = order[k];
+			ranked_bounds[c * items + k] = bounds[order[k]][c];
+		}
+	}
+}
+
+std::vector<double> MFIIndex::cell_bounds(Estimator &estimator, const QuestionSet &questionSet, int item) const {
+	const double width = (upper - lower) / cells;
+	const double discrimination = questionSet.discrimination[item];
+	std::vector<double> bounds(cells);
+
+	if ((questionSet.modelType == ModelType::LTM) || (questionSet.modelType == ModelType::TPM)) {
+		// information peaks where the logit is log((1 + sqrt(1 + 8c)) / 2), c the guessing parameter
+		const double guessing = questionSet.guessing[item];
+		const double peak_logit = std::log((1.0 + std::sqrt(1.0 + 8.0 * guessing)) / 2.0);
+		const double peak = discrimination == 0.0 ? lower : (peak_logit - questionSet.difficulty[item][0]) / discrimination;
+		for (size_t c = 0; c < cells; ++c) {
+			const double theta = std::min(std::max(peak, lower + c * width), lower + (c + 1) * width);
+			bounds[c] = estimator.fisherInf(theta, item) * (1.0 + relative_slack);
+		}
+		return bounds;
+	}
+
+	const size_t per_cell = std::max<size_t>(8, (size_t) std::ceil(width / sample_spacing));
+	const double spacing = width / per_cell;
+	std::vector<double> points(cells * per_cell + 1);
+	for (size_t i = 0; i < points.size(); ++i) {
+		points[i] = lower + i * spacing;
+	}
+	std::vector<double> information(points.size());
+	estimator.fisherInf(points.data(), points.size(), item, information.data());
+
+	// any theta in a cell is within spacing / 2 of one of its points
+	const double a = std::abs(discrimination);
+	const double thresholds = (double) questionSet.difficulty[item].size();
+	for (size_t c = 0; c < cells; ++c) {
+		const double largest = *std::max_element(information.begin() + c * per_cell,
+		                                         information.begin() + (c + 1) * per_cell + 1);
+		double bound;
+		if (questionSet.modelType == ModelType::GRM) {
+			const double offset = a * a * thresholds;
+			bound = (largest + offset) * std::exp(a * spacing / 2.0) - offset;
+		} else {
+			bound = largest * std::exp(a * thresholds * spacing / 2.0);
+		}
+		bounds[c] = bound * (1.0 + relative_slack);
+	}
+	return bounds;
+}
+
+bool MFIIndex::matches(double lowerBound, double upperBound, size_t cellCount) const {
+	return lower == lowerBound && upper == upperBound && cells == cellCount;
+}
+
+bool MFIIndex::select(double theta, Estimator &estimator, const std::vector<int> &answers,
+                      Selection &selection) const {
+	if (!(theta >= lower && theta <= upper)) {
+		return false;
+	}
+	const size_t cell = std::min(cells - 1, (size_t) ((theta - lower) / (upper - lower) * cells));
+	const int *order = &ranked_items[cell * items];
+	const double *bound = &ranked_bounds[cell * items];
+
+	std::vector<std::pair<int, double> > scored;
+	double best = -std::numeric_limits<double>::infinity();
+	int best_item = -1;
+	for (size_t k = 0; k < items && bound[k] >= best; ++k) {
+		const int item = order[k];
+		if (answers[item] != NA_INTEGER) {
+			continue;
+		}
+		const double value = estimator.fisherInf(theta, item);
+		scored.emplace_back(item, value);
+		// ties go to the lower item number, as with full scoring
+		if (value > best || (value == best && item < best_item)) {
+			best = value;
+			best_item = item;
+		}
+	}
+	if (best_item < 0) {
+		return false;
+	}
+
+	std::sort(scored.begin(), scored.end());
+	selection.questions.clear();
+	selection.values.clear();
+	for (auto &candidate : scored) {
+		selection.questions.push_back(candidate.first);
+		selection.values.push_back(candidate.second);
+	}
+	selection.item = best_item;
+	return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include "Selection.h"
+
+class Estimator;
+struct QuestionSet;
+
+/**
+ * A ranking of the items by Fisher information, precomputed for a bank, so that MFI selection does not have to
+ * score every unanswered item.
+ *
+ * The range of theta is cut into cells of equal width. For every cell the index stores an upper bound on each
+ * item's information anywhere in the cell, with the items sorted by that bound. Selecting at theta walks the cell's
+ * list, skipping answered items, and scores exact information until the next bound falls below the best score
+ * found; no item further down the list can beat it, so the result is the item full MFI scoring would pick.
+ *
+ * The bounds are exact for ltm/tpm, whose information is unimodal in theta. For grm and gpcm they come from the
+ * information at closely spaced points of the cell, widened by how fast the information can change between them:
+ * |I'| <= a I + a^3 k for grm and |I'| <= a k I for gpcm, with a the discrimination and k the number of thresholds.
+ */
+class MFIIndex {
+public:
+	MFIIndex();
+
+	void build(Estimator &estimator, const QuestionSet &questionSet, double lower, double upper, size_t cells);
+
+	/**
+	 * Whether this index was built for the given range and number of cells.
+	 */
+	bool matches(double lower, double upper, size_t cells) const;
+
+	/**
+	 * Fills selection.questions and selection.values with the unanswered items that had to be scored and
+	 * selection.item with the most informative of them. Returns false, leaving selection untouched, when theta lies
+	 * outside the indexed range.
+	 */
+	bool select(double theta, Estimator &estimator, const std::vector<int> &answers, Selection &selection) const;
+
+private:
+	std::vector<double> cell_bounds(Estimator &estimator, const QuestionSet &questionSet, int item) const;
+
+	double lower;
+	double upper;
+	size_t cells;
+	size_t items;
+	std::vector<int> ranked_items;
+	std::vector<double> ranked_bounds;
+};
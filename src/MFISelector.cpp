@@ -21,19 +21,29 @@ SelectionType MFISelector::getSelectionType() {
 
 Selection MFISelector::selectItem() {
 	Selection selection;
-	selection.questions = questionSet.nonapplicable_rows;
 	selection.name = "MFI";
 
-	double theta = estimator.estimateTheta(prior);
+	const SelectionContext context = estimator.selectionContext(prior, SelectionContext::THETA);
+	double theta = context.theta;
 
-	selection.values.resize(selection.questions.size());
+	// with an index, only the items it cannot rule out are scored (and listed in the selection)
+	if (mfiIndex == nullptr || !mfiIndex->select(theta, estimator, questionSet.answers, selection)) {
+		selection.questions = questionSet.nonapplicable_rows;
 
-	mpl::ParallelHelper<MFI> helper(selection.questions, selection.values, estimator, theta);
-   	// call parallelFor to do the work
-  	RcppParallel::parallelFor(0, selection.questions.size(), helper);
+		if ((questionSet.modelType == ModelType::LTM) || (questionSet.modelType == ModelType::TPM)) {
+			// a single vectorized pass over the candidates is cheaper than spreading them across threads
+			selection.values = estimator.fisherInf(theta, selection.questions);
+		} else {
+			selection.values.resize(selection.questions.size());
 
-	auto max_itr = std::max_element(selection.values.begin(), selection.values.end());
-	selection.item = selection.questions.at(std::distance(selection.values.begin(),max_itr));
+			mpl::ParallelHelper<MFI> helper(selection.questions, selection.values, estimator, theta);
+		   	// call parallelFor to do the work
+		  	mpl::parallelFor(0, selection.questions.size(), helper);
+		}
+
+		auto max_itr = std::max_element(selection.values.begin(), selection.values.end());
+		selection.item = selection.questions.at(std::distance(selection.values.begin(),max_itr));
+	}
 
 	selection.question_names.resize(selection.questions.size());
 
@@ -1,15 +1,15 @@
 #include "MLWISelector.h"
 #include "ParallelUtil.h"
 
-struct MLWI : public mpl::FunctionCaller<double>
+struct MLWI : public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<double>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	MLWI(Estimator& e, double& p):Base{e,p}{}
+	MLWI(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
-		return estimator.lwi(question);
+		return estimator.lwi(question, arg);
 	}
 };
 
@@ -22,13 +22,21 @@ Selection MLWISelector::selectItem() {
 	selection.name = "MLWI";
 	selection.questions = questionSet.nonapplicable_rows;
 	
-	double dummy = 0;
+	const SelectionContext context = estimator.selectionContext(prior, SelectionContext::LIKELIHOOD_WEIGHTS);
 
 	selection.values.resize(selection.questions.size());
 
-	mpl::ParallelHelper<MLWI> helper(selection.questions, selection.values, estimator, dummy);
-   	// call parallelFor to do the work
-  	RcppParallel::parallelFor(0, selection.questions.size(), helper);
+	if (context.posterior) {
+		// the likelihood weights are the same for every candidate, so all the scores come from one
+		// product of the information table with those weights
+		context.posterior->getTables().informationProduct(selection.questions, context.likelihoodWeights.data(),
+		                                                  selection.values.data());
+	} else {
+		prioritize(context, selection);
+		mpl::ParallelHelper<MLWI> helper(selection.questions, selection.values, estimator, context);
+	   	// call score to do the work
+	  	score(selection, helper);
+	}
 
 	auto max_itr = std::max_element(selection.values.begin(), selection.values.end());
 	selection.item = selection.questions.at(std::distance(selection.values.begin(),max_itr));
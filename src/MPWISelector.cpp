@@ -1,11 +1,11 @@
 #include "MPWISelector.h"
 #include "ParallelUtil.h"
 
-struct MPWI : public mpl::FunctionCaller<Prior>
+struct MPWI : public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<Prior>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	MPWI(Estimator& e, Prior& p):Base{e,p}{}
+	MPWI(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
@@ -22,11 +22,21 @@ Selection MPWISelector::selectItem() {
 	selection.name = "MPWI";
 	selection.questions = questionSet.nonapplicable_rows;
 	
+	const SelectionContext context = estimator.selectionContext(prior, SelectionContext::POSTERIOR_WEIGHTS);
+
 	selection.values.resize(selection.questions.size());
 
-	mpl::ParallelHelper<MPWI> helper(selection.questions, selection.values, estimator, prior);
-   	// call parallelFor to do the work
-  	RcppParallel::parallelFor(0, selection.questions.size(), helper);
+	if (context.posterior) {
+		// the posterior weights are the same for every candidate, so all the scores come from one
+		// product of the information table with those weights
+		context.posterior->getTables().informationProduct(selection.questions, context.posteriorWeights.data(),
+		                                                  selection.values.data());
+	} else {
+		prioritize(context, selection);
+		mpl::ParallelHelper<MPWI> helper(selection.questions, selection.values, estimator, context);
+	   	// call score to do the work
+	  	score(selection, helper);
+	}
 
 	auto max_itr = std::max_element(selection.values.begin(), selection.values.end());
 	selection.item = selection.questions.at(std::distance(selection.values.begin(),max_itr));
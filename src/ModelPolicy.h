@@ -0,0 +1,574 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "ProbabilityKernels.h"
+
+enum class ModelType {
+	LTM, TPM, GRM, GPCM
+};
+
+/**
+ * Per-item response functions of each IRT model, written as policy classes with static members so that the loops
+ * in Estimator can be instantiated once per model. Choosing the model is then done once, when the Estimator is
+ * built, instead of comparing model strings on every likelihood or derivative evaluation; inside a loop every call
+ * is known at compile time and can be inlined.
+ *
+ * The formulas are those of Estimator.cpp (prob_ltm, prob_grm_pair, prob_gpcm_at, and the per-item terms of the
+ * d1LL/d2LL functions). Like ProbabilityKernels.h, this header does not depend on Rcpp.
+ */
+namespace model
+{
+	/**
+	 * One item's parameters, as laid out in the ItemBank.
+	 */
+	struct Item
+	{
+		double discrimination;
+		double guessing;
+		const double *thresholds;
+		std::size_t count;
+	};
+
+	/**
+	 * A probability that cannot be computed reliably at the given theta. Unlike Rcpp::stop, which calls into R, it
+	 * may be thrown on a worker thread; Rcpp turns it into an R error once it reaches the exported function.
+	 */
+	struct NumericalError : public std::runtime_error
+	{
+		explicit NumericalError(const std::string &message) : std::runtime_error(message) { }
+	};
+
+	/**
+	 * Reports a theta too extreme for the probability functions by throwing a NumericalError. Defined in
+	 * Estimator.cpp.
+	 */
+	[[noreturn]] void extreme_theta(double theta);
+
+	/**
+	 * ltm and tpm.
+	 */
+	struct Binary
+	{
+		static double probability(double theta, const Item &item)
+		{
+			if (theta > 20.0 || theta < -20.0)
+			{
+				extreme_theta(theta);
+			}
+
+			double exp_prob_bi = std::exp(item.thresholds[0] + (item.discrimination * theta));
+			if (std::isinf(exp_prob_bi))
+			{
+				return 1.0 - kernels::eps;
+			}
+
+			double result = item.guessing + (1 - item.guessing) * (exp_prob_bi / (1 + exp_prob_bi));
+			if (result > (1.0 - kernels::eps))
+			{
+				result = 1.0 - kernels::eps;
+			}
+			else if (result < kernels::eps)
+			{
+				result = kernels::eps;
+			}
+			return result;
+		}
+
+		static double logProbability(double theta, const Item &item, int answer)
+		{
+			double prob = probability(theta, item);
+			return (answer * std::log(prob)) + ((1 - answer) * std::log(1 - prob));
+		}
+
+		/**
+		 * out[i] += logProbability(theta[i], item, answer) for i < n, with the probabilities from the batch kernel.
+		 */
+		static void addLogProbabilities(const double *theta, std::size_t n, const Item &item, int answer, double *out)
+		{
+			double P[64];
+			for (std::size_t start = 0; start < n; start += 64)
+			{
+				const std::size_t count = std::min<std::size_t>(64, n - start);
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					if (theta[start + i] > 20.0 || theta[start + i] < -20.0)
+					{
+						extreme_theta(theta[start + i]);
+					}
+				}
+
+				kernels::ltm_probability(theta + start, count, item.thresholds[0], item.discrimination, item.guessing, P);
+				for (std::size_t i = 0; i < count; ++i)
+				{
+					out[start + i] += (answer * std::log(P[i])) + ((1 - answer) * std::log(1 - P[i]));
+				}
+			}
+		}
+
+		static double d1(double theta, const Item &item, int answer)
+		{
+			double P = probability(theta, item);
+			return item.discrimination * ((P - item.guessing) / (P * (1 - item.guessing))) * (answer - P);
+		}
+
+		static double d2(double theta, const Item &item, int)
+		{
+			double P = probability(theta, item);
+			double Q = 1.0 - P;
+			double lambda_temp = (P - item.guessing) / (1.0 - item.guessing);
+			return -std::pow(item.discrimination * lambda_temp, 2.0) * (Q / P);
+		}
+
+		static std::size_t categoryCount(const Item &)
+		{
+			return 2;
+		}
+
+		/**
+		 * The probability of each response category (0, then 1) at theta.
+		 */
+		static void categoryProbabilities(double theta, const Item &item, double *out)
+		{
+			const double P = probability(theta, item);
+			out[0] = 1.0 - P;
+			out[1] = P;
+		}
+
+		static double kl(double theta_not, double theta, const Item &item)
+		{
+			const double prob_theta_not = probability(theta_not, item);
+			const double prob_theta_hat = probability(theta, item);
+
+			double first_term = prob_theta_not * (std::log(prob_theta_not) - std::log(prob_theta_hat));
+			double second_term = (1 - prob_theta_not) * (std::log(1 - prob_theta_not) - std::log(1 - prob_theta_hat));
+			return first_term + second_term;
+		}
+	};
+
+	/**
+	 * grm.
+	 */
+	struct Graded
+	{
+		/**
+		 * The cumulative probability of the boundary with the given difficulty.
+		 */
+		static double cumulative(double theta_desc, double difficulty)
+		{
+			double exp_prob = std::exp(difficulty - theta_desc);
+			if (std::isinf(exp_prob))
+			{
+				return 1.0 - kernels::eps;
+			}
+
+			double result = exp_prob / (1 + exp_prob);
+			if (result > (1.0 - kernels::eps))
+			{
+				result = 1.0 - kernels::eps;
+			}
+			else if (result < kernels::eps)
+			{
+				result = kernels::eps;
+			}
+			return result;
+		}
+
+		/**
+		 * The cumulative probabilities below and at category `at` (1-based).
+		 */
+		static std::pair<double, double> boundaries(double theta, const Item &item, std::size_t at)
+		{
+			const double theta_desc = theta * item.discrimination;
+			std::pair<double, double> probs;
+			probs.first = at == 1 ? 0.0 : cumulative(theta_desc, item.thresholds[at - 2]);
+			probs.second = at == item.count + 1 ? 1.0 : cumulative(theta_desc, item.thresholds[at - 1]);
+
+			if (probs.first == probs.second)
+			{
+				extreme_theta(theta);
+			}
+			return probs;
+		}
+
+		static double logProbability(double theta, const Item &item, int answer)
+		{
+			auto probs = boundaries(theta, item, answer);
+			return std::log(probs.second - probs.first);
+		}
+
+		static void addLogProbabilities(const double *theta, std::size_t n, const Item &item, int answer, double *out)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				out[i] += logProbability(theta[i], item, answer);
+			}
+		}
+
+		static double d1(double theta, const Item &item, int answer)
+		{
+			auto probs = boundaries(theta, item, answer);
+			double P = probs.second - probs.first;
+			double w = probs.second * (1.0 - probs.second) - probs.first * (1 - probs.first);
+			return -1 * item.discrimination * (w / P);
+		}
+
+		/**
+		 * The second derivative of the item's log-probability, before scaling by the squared discrimination.
+		 */
+		static double partial_d2(double theta, const Item &item, int answer)
+		{
+			auto probs = boundaries(theta, item, answer);
+			double P_star2 = probs.first;
+			double P_star1 = probs.second;
+			double P = P_star1 - P_star2;
+
+			double Q_star1 = 1 - P_star1;
+			double Q_star2 = 1 - P_star2;
+
+			double w2 = P_star2 * Q_star2;
+			double w1 = P_star1 * Q_star1;
+			double w = w1 - w2;
+
+			double first_term = (-w2 * (Q_star2 - P_star2) + w1 * (Q_star1 - P_star1)) / P;
+			double second_term = std::pow(w, 2.0) / std::pow(P, 2.0);
+			return first_term - second_term;
+		}
+
+		static double d2(double theta, const Item &item, int answer)
+		{
+			return std::pow(item.discrimination, 2.0) * partial_d2(theta, item, answer);
+		}
+
+		static std::size_t categoryCount(const Item &item)
+		{
+			return item.count + 1;
+		}
+
+		/**
+		 * The probability of each response category at theta, from one pass over the boundaries.
+		 */
+		static void categoryProbabilities(double theta, const Item &item, double *out)
+		{
+			const double theta_desc = theta * item.discrimination;
+			double below = 0.0;
+			for (std::size_t i = 0; i <= item.count; ++i)
+			{
+				double at = i == item.count ? 1.0 : cumulative(theta_desc, item.thresholds[i]);
+				if (at == below)
+				{
+					extreme_theta(theta);
+				}
+				out[i] = at - below;
+				below = at;
+			}
+		}
+
+		static double kl(double theta_not, double theta, const Item &item)
+		{
+			const double desc_not = theta_not * item.discrimination;
+			const double desc_hat = theta * item.discrimination;
+
+			double sum = 0.0;
+			double below_not = 0.0;
+			double below_hat = 0.0;
+			for (std::size_t i = 0; i <= item.count; ++i)
+			{
+				double at_not = i == item.count ? 1.0 : cumulative(desc_not, item.thresholds[i]);
+				double at_hat = i == item.count ? 1.0 : cumulative(desc_hat, item.thresholds[i]);
+				if (at_not == below_not)
+				{
+					extreme_theta(theta_not);
+				}
+				if (at_hat == below_hat)
+				{
+					extreme_theta(theta);
+				}
+
+				double prob_theta_not = at_not - below_not;
+				double prob_theta_hat = at_hat - below_hat;
+				sum += prob_theta_not * (std::log(prob_theta_not) - std::log(prob_theta_hat));
+				below_not = at_not;
+				below_hat = at_hat;
+			}
+			return sum;
+		}
+	};
+
+	/**
+	 * gpcm.
+	 */
+	struct PartialCredit
+	{
+		/**
+		 * The probability of category `at` (0-based).
+		 */
+		static double probability(double theta, const Item &item, std::size_t at)
+		{
+			const double discrimination = item.discrimination;
+			const double *categoryparams = item.thresholds;
+
+			double sum = discrimination * theta;
+			double denominator = std::exp(sum);
+
+			double result = -1;
+			if (at == 0)
+			{
+				result = denominator;
+				for (std::size_t i = 0; i < item.count; ++i)
+				{
+					sum += discrimination * (theta - categoryparams[i]);
+					denominator += std::exp(sum);
+				}
+			}
+			else
+			{
+				at -= 1;
+				for (std::size_t i = 0; i != at; ++i)
+				{
+					sum += discrimination * (theta - categoryparams[i]);
+					denominator += std::exp(sum);
+				}
+
+				sum += discrimination * (theta - categoryparams[at]);
+				result = std::exp(sum);
+				denominator += result;
+
+				for (std::size_t i = at + 1; i < item.count; ++i)
+				{
+					sum += discrimination * (theta - categoryparams[i]);
+					denominator += std::exp(sum);
+				}
+			}
+
+			if (denominator == 0.0 || std::isinf(denominator))
+			{
+				extreme_theta(theta);
+			}
+			return result / denominator;
+		}
+
+		static double logProbability(double theta, const Item &item, int answer)
+		{
+			return std::log(probability(theta, item, ((std::size_t) answer) - 1));
+		}
+
+		static void addLogProbabilities(const double *theta, std::size_t n, const Item &item, int answer, double *out)
+		{
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				out[i] += logProbability(theta[i], item, answer);
+			}
+		}
+
+		static double d1(double theta, const Item &item, int answer)
+		{
+			std::size_t index = ((std::size_t) answer) - 1;
+			const double discrimination = item.discrimination;
+			const double *categoryparams = item.thresholds;
+
+			double f = -1;
+			double f_prime = -1;
+			double sum = discrimination * (theta - 0.0);
+			double g = std::exp(sum);
+			double x = discrimination;
+			double g_prime = g * x;
+
+			if (index == 0)
+			{
+				f = g;
+				f_prime = g_prime;
+				for (std::size_t i = 0; i < item.count; ++i)
+				{
+					sum += discrimination * (theta - categoryparams[i]);
+					double num = std::exp(sum);
+					x += discrimination;
+					g += num;
+					g_prime += num * x;
+				}
+			}
+			else
+			{
+				index -= 1;
+				for (std::size_t i = 0; i != index; ++i)
+				{
+					sum += discrimination * (theta - categoryparams[i]);
+					double num = std::exp(sum);
+					x += discrimination;
+					g += num;
+					g_prime += num * x;
+				}
+
+				sum += discrimination * (theta - categoryparams[index]);
+				f = std::exp(sum);
+				x += discrimination;
+				f_prime = f * x;
+				g += f;
+				g_prime += f_prime;
+
+				for (std::size_t i = index + 1; i < item.count; ++i)
+				{
+					sum += discrimination * (theta - categoryparams[i]);
+					double num = std::exp(sum);
+					x += discrimination;
+					g += num;
+					g_prime += num * x;
+				}
+			}
+
+			if (g == 0.0 || std::isinf(g))
+			{
+				extreme_theta(theta);
+			}
+			return (g * f_prime - f * g_prime) / (g * f);
+		}
+
+		static double d2(double theta, const Item &item, int answer)
+		{
+			std::size_t index = ((std::size_t) answer) - 1;
+			const double discrimination = item.discrimination;
+			const double *categoryparams = item.thresholds;
+
+			double f = -1;
+			double f_prime = -1;
+			double f_primeprime = -1;
+			double sum = discrimination * (theta - 0.0);
+			double g = std::exp(sum);
+			double x = discrimination;
+			double g_prime = g * x;
+			double g_primeprime = g_prime * x;
+
+			if (index == 0)
+			{
+				f = g;
+				f_prime = g_prime;
+				f_primeprime = g_primeprime;
+				for (std::size_t i = 0; i < item.count; ++i)
+				{
+					sum += discrimination * (theta - categoryparams[i]);
+					double num = std::exp(sum);
+					x += discrimination;
+					double num_x = num * x;
+					g += num;
+					g_prime += num_x;
+					g_primeprime += num_x * x;
+				}
+			}
+			else
+			{
+				index -= 1;
+				for (std::size_t i = 0; i != index; ++i)
+				{
+					sum += discrimination * (theta - categoryparams[i]);
+					double num = std::exp(sum);
+					x += discrimination;
+					double num_x = num * x;
+					g += num;
+					g_prime += num_x;
+					g_primeprime += num_x * x;
+				}
+
+				sum += discrimination * (theta - categoryparams[index]);
+				f = std::exp(sum);
+				x += discrimination;
+				f_prime = f * x;
+				f_primeprime = f_prime * x;
+				g += f;
+				g_prime += f_prime;
+				g_primeprime += f_primeprime;
+
+				for (std::size_t i = index + 1; i < item.count; ++i)
+				{
+					sum += discrimination * (theta - categoryparams[i]);
+					double num = std::exp(sum);
+					x += discrimination;
+					double num_x = num * x;
+					g += num;
+					g_prime += num_x;
+					g_primeprime += num_x * x;
+				}
+			}
+
+			if (g == 0.0 || std::isinf(g))
+			{
+				extreme_theta(theta);
+			}
+
+			double b = g * g;
+			double b2 = b * b;
+			double b_prime = 2.0 * g * g_prime;
+
+			double a = g * f_prime - f * g_prime;
+			f_prime = a / b; // p_prime
+
+			double a_prime = f_primeprime * g - g_primeprime * f;
+			f_primeprime = (b * a_prime - a * b_prime) / b2; // p_primeprime
+
+			f /= g; // p
+
+			return -((f_prime * f_prime / f - f_primeprime) / f);
+		}
+
+		static std::size_t categoryCount(const Item &item)
+		{
+			return item.count + 1;
+		}
+
+		/**
+		 * The probability of each response category at theta. The running sums are those of probability(), but
+		 * the exponentials are taken once for all categories instead of once per category.
+		 */
+		static void categoryProbabilities(double theta, const Item &item, double *out)
+		{
+			const double discrimination = item.discrimination;
+			double sum = discrimination * theta;
+			out[0] = std::exp(sum);
+			double denominator = out[0];
+			for (std::size_t i = 0; i < item.count; ++i)
+			{
+				sum += discrimination * (theta - item.thresholds[i]);
+				out[i + 1] = std::exp(sum);
+				denominator += out[i + 1];
+			}
+
+			if (denominator == 0.0 || std::isinf(denominator))
+			{
+				extreme_theta(theta);
+			}
+			for (std::size_t i = 0; i <= item.count; ++i)
+			{
+				out[i] /= denominator;
+			}
+		}
+
+		static double kl(double theta_not, double theta, const Item &item)
+		{
+			double sum = 0.0;
+			for (std::size_t i = 0; i <= item.count; ++i)
+			{
+				double prob_theta_not = probability(theta_not, item, i);
+				double prob_theta_hat = probability(theta, item, i);
+				sum += prob_theta_not * (std::log(prob_theta_not) - std::log(prob_theta_hat));
+			}
+			return sum;
+		}
+	};
+
+	/**
+	 * The KL divergence of the response distribution at theta_not from the one at theta, given the category
+	 * probabilities at theta_not and the log category probabilities at theta. The theta side is the same for every
+	 * evaluation of a KL integrand, so the selectors compute it once per item.
+	 */
+	inline double kl(const double *probs_not, const double *log_probs_hat, std::size_t categories)
+	{
+		double sum = 0.0;
+		for (std::size_t c = 0; c < categories; ++c)
+		{
+			sum += probs_not[c] * (std::log(probs_not[c]) - log_probs_hat[c]);
+		}
+		return sum;
+	}
+}
@@ -1,11 +1,11 @@
 #include "PKLSelector.h"
 #include "ParallelUtil.h"
 
-struct PKL : public mpl::FunctionCaller<Prior>
+struct PKL : public mpl::FunctionCaller<const SelectionContext>
 {
-	using Base = mpl::FunctionCaller<Prior>;
+	using Base = mpl::FunctionCaller<const SelectionContext>;
 
-	PKL(Estimator& e, Prior& p):Base{e,p}{}
+	PKL(Estimator& e, const SelectionContext& c):Base{e,c}{}
 
 	double operator()(int question)
 	{
@@ -21,13 +21,16 @@ SelectionType PKLSelector::getSelectionType() {
 Selection PKLSelector::selectItem() {
 	Selection selection;
 	selection.name = "PKL";
-	selection.questions = questionSet.nonapplicable_rows;
 	
+	const SelectionContext context = estimator.selectionContext(prior, SelectionContext::THETA | SelectionContext::POSTERIOR_WEIGHTS);
+	selection.questions = candidates(context.theta, selection);
+
+	prioritize(context, selection);
 	selection.values.resize(selection.questions.size());
 
-	mpl::ParallelHelper<PKL> helper(selection.questions, selection.values, estimator, prior);
-   	// call parallelFor to do the work
-  	RcppParallel::parallelFor(0, selection.questions.size(), helper);
+	mpl::ParallelHelper<PKL> helper(selection.questions, selection.values, estimator, context);
+   	// call score to do the work
+  	score(selection, helper);
 
 	auto max_itr = std::max_element(selection.values.begin(), selection.values.end());
 	selection.item = selection.questions.at(std::distance(selection.values.begin(),max_itr));
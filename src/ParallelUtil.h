@@ -1,13 +1,111 @@
 #pragma once
 #include "Estimator.h"
+#include "Warnings.h"
 
 #include <RcppParallel.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
 
 
 //using namespace RcppParallel;
 
 namespace mpl
 {
+	/**
+	 * The number of threads RcppParallel runs: RCPP_PARALLEL_NUM_THREADS, which RcppParallel::setThreadOptions()
+	 * sets, or else one per core.
+	 */
+	inline std::size_t threadCount()
+	{
+		const char *setting = std::getenv("RCPP_PARALLEL_NUM_THREADS");
+		if (setting != nullptr && std::atoi(setting) > 0) {
+			return (std::size_t) std::atoi(setting);
+		}
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	/**
+	 * The outcome of a parallel loop. Workers must neither call into R (Rcpp::stop included) nor let an exception
+	 * escape into the thread pool, so they record the first failure here as a code and a message; once parallelFor
+	 * has returned, the main thread rethrows it as an exception of the original type.
+	 */
+	class WorkerStatus
+	{
+	public:
+		enum Code { OK, NUMERICAL_ERROR, DOMAIN_ERROR, OUT_OF_RANGE, RUNTIME_ERROR, BAD_ALLOC, FAILURE };
+
+		WorkerStatus() : code(OK) { }
+
+		bool failed() const
+		{
+			return code.load(std::memory_order_relaxed) != OK;
+		}
+
+		/**
+		 * Calls body, recording whatever it throws.
+		 */
+		template<typename Body>
+		void run(Body body)
+		{
+			try {
+				body();
+			} catch (const model::NumericalError &e) {
+				record(NUMERICAL_ERROR, e.what());
+			} catch (const std::domain_error &e) {
+				record(DOMAIN_ERROR, e.what());
+			} catch (const std::out_of_range &e) {
+				record(OUT_OF_RANGE, e.what());
+			} catch (const std::bad_alloc &) {
+				record(BAD_ALLOC, "");
+			} catch (const std::exception &e) {
+				record(RUNTIME_ERROR, e.what());
+			} catch (...) {
+				record(FAILURE, "Unknown error in a worker thread.");
+			}
+		}
+
+		/**
+		 * Called on the main thread after the loop.
+		 */
+		void rethrow() const
+		{
+			switch (code.load()) {
+			case OK:
+				return;
+			case NUMERICAL_ERROR:
+				throw model::NumericalError(message);
+			case DOMAIN_ERROR:
+				throw std::domain_error(message);
+			case OUT_OF_RANGE:
+				throw std::out_of_range(message);
+			case BAD_ALLOC:
+				throw std::bad_alloc();
+			default:
+				throw std::runtime_error(message);
+			}
+		}
+
+	private:
+		void record(Code failure, const char *what)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (code.load() == OK) {
+				message = what;
+				code.store(failure);
+			}
+		}
+
+		std::atomic<int> code;
+		std::mutex mutex;
+		std::string message;
+	};
+
 	template<typename Arg>
 	struct FunctionCaller
 	{
@@ -28,6 +126,7 @@ namespace mpl
 	   const std::vector<int>& input; // source vector
 	   std::vector<double>& output; // destination vector
 	   Function f;
+	   WorkerStatus status;
 	   
 	   // initialize with source and destination
 	   template<typename T1, typename T2, typename Arg>
@@ -37,10 +136,27 @@ namespace mpl
 	      , f{e,a}
 	      {}
 	   
-	   // take the range of elements requested
+	   // take the range of elements requested; once any range has failed the rest are skipped
 	   void operator()(std::size_t begin, std::size_t end)
 	   {
-	      std::transform(input.begin() + begin, input.begin() + end, output.begin() + begin, f);
+	      if (status.failed()) {
+	         return;
+	      }
+	      status.run([&]() {
+	         std::transform(input.begin() + begin, input.begin() + end, output.begin() + begin, f);
+	      });
 	   }
 	};
-}
\ No newline at end of file
+
+	/**
+	 * RcppParallel::parallelFor for workers with a WorkerStatus member named status. Back on the calling thread it
+	 * prints the warnings the workers held back and rethrows the first failure.
+	 */
+	template<typename Worker>
+	void parallelFor(std::size_t begin, std::size_t end, Worker& worker, std::size_t grainSize = 1)
+	{
+		RcppParallel::parallelFor(begin, end, worker, grainSize);
+		warnings::flush();
+		worker.status.rethrow();
+	}
+}
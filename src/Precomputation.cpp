@@ -0,0 +1,125 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include "Precomputation.h"
+#include "ItemTables.h"
+#include "Instrumentation.h"
+
+Precomputation::Precomputation(Cat &cat) : cat(cat), item(-1), current(-1), cancelled(false) { }
+
+Precomputation::~Precomputation() {
+	stop();
+}
+
+void Precomputation::start(int question) {
+	const std::vector<int> &unanswered = cat.questionSet.nonapplicable_rows;
+	if (std::find(unanswered.begin(), unanswered.end(), question) == unanswered.end()) {
+		Rcpp::stop("Only an unanswered item can be precomputed.");
+	}
+	if (unanswered.size() == 1) {
+		Rcpp::stop("The last unanswered item cannot be precomputed.");
+	}
+	if (cat.selectsOnMainThread()) {
+		Rcpp::stop("RANDOM selection draws from R's generator and cannot be precomputed.");
+	}
+	if (cat.lookAheadDepth > 0) {
+		Rcpp::stop("Lookahead selection cannot be precomputed.");
+	}
+	stop();
+
+	// the likeliest answers first, so that a cancelled run has most likely selected the answer given
+	const double theta = cat.estimator->estimateTheta(cat.prior);
+	const std::vector<double> probabilities = ItemTables::categoryProbabilities(cat.estimator->probability(theta, question),
+	                                                                            cat.questionSet.modelType);
+	const std::vector<int> answers = cat.responseOptions(question);
+	std::vector<size_t> order(probabilities.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return probabilities[a] > probabilities[b];
+	});
+
+	// the first response option is the skip, which carries no probability
+	options.clear();
+	for (size_t c : order) {
+		options.push_back(answers.at(c + 1));
+	}
+	options.push_back(answers.at(0));
+	items.assign(options.size(), -1);
+
+	item = question;
+	base.reset(new Cat::Branch(cat));
+	cancelled = false;
+	// the likeliest option counts as started, whether or not the thread has been scheduled yet
+	current = 0;
+	thread = std::thread(&Precomputation::run, this);
+}
+
+void Precomputation::cancel() {
+	cancelled = true;
+}
+
+void Precomputation::stop() {
+	cancelled = true;
+	if (thread.joinable()) {
+		thread.join();
+	}
+}
+
+void Precomputation::run() {
+	for (size_t i = 0; i < options.size() && (i == 0 || !cancelled); ++i) {
+		current = (int) i;
+		try {
+			Cat::Branch branch(cat, *base, item, options[i]);
+			const int next = branch.selector->selectItem().item;
+			std::lock_guard<std::mutex> lock(mutex);
+			items[i] = next;
+		} catch (...) {
+			// nextItem selects this option on the main thread, where the failure reaches R
+			break;
+		}
+	}
+	current = -1;
+}
+
+int Precomputation::nextItem() {
+	if (cat.questionSet.nonapplicable_rows.empty()) {
+		Rcpp::stop("sessionNextItem should not be called if all items have been answered.");
+	}
+	const int option = storedOption();
+	if (option >= 0) {
+		const bool selecting = current == option;
+		int next = selected(option);
+		if (next < 0 && selecting) {
+			stop();
+			next = selected(option);
+		}
+		if (next >= 0) {
+			instrumentation::count(instrumentation::precomputedHits);
+			return next;
+		}
+	}
+	cancel();
+	instrumentation::count(instrumentation::precomputedMisses);
+	return cat.nextItem();
+}
+
+int Precomputation::storedOption() const {
+	if (!base) {
+		return -1;
+	}
+	const std::vector<int> &answers = cat.questionSet.answers;
+	const std::vector<int> &started = base->questionSet.answers;
+	for (size_t i = 0; i < answers.size(); ++i) {
+		if (answers[i] != started[i] && (int) i != item) {
+			return -1;
+		}
+	}
+	const auto stored = std::find(options.begin(), options.end(), answers[item]);
+	return stored == options.end() ? -1 : (int) (stored - options.begin());
+}
+
+int Precomputation::selected(int option) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return items[option];
+}
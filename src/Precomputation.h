@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Cat.h"
+
+/**
+ * Speculative selection for a session. While the respondent considers an item, start() selects the next item after
+ * each of its response options on a background thread, every option on a Cat::Branch of its own, so that once the
+ * answer is stored nextItem() only has to look it up. This is the work lookAhead does, done ahead of time.
+ *
+ * The options are selected one after another, the likeliest at the current estimate of theta first and the skip
+ * last, each selection running its own parallel loop. The thread works from a Branch copied from the Cat when it
+ * started and from the Cat's read-only parts, so answers may be stored while it runs. cancel() stops it after the
+ * option it is selecting, and never before the likeliest option; the options already selected stay available.
+ */
+class Precomputation {
+public:
+	explicit Precomputation(Cat &cat);
+	~Precomputation();
+	Precomputation(const Precomputation &) = delete;
+	Precomputation &operator=(const Precomputation &) = delete;
+
+	/**
+	 * Cancels any earlier run, waiting for it to stop, and starts selecting on the response options of question
+	 * (0-indexed), which must be unanswered and not the last unanswered item.
+	 */
+	void start(int question);
+
+	void cancel();
+
+	/**
+	 * The item (0-indexed) Cat::nextItem would choose now: looked up if the Cat's answers are those start() saw
+	 * plus an answer to its item, and that option has been selected or is being selected; selected on the spot
+	 * otherwise.
+	 */
+	int nextItem();
+
+private:
+	Cat &cat;
+	std::unique_ptr<Cat::Branch> base;
+	int item;
+	/**
+	 * The response options of item in the order they are selected, and the item selected after each (-1 until
+	 * it has been). items is guarded by mutex.
+	 */
+	std::vector<int> options;
+	std::vector<int> items;
+	std::mutex mutex;
+	std::atomic<int> current;
+	std::atomic<bool> cancelled;
+	std::thread thread;
+
+	void run();
+	void stop();
+
+	/**
+	 * The index in options of the answer the Cat gave to item, or -1 if the Cat's answers have otherwise changed.
+	 */
+	int storedOption() const;
+	int selected(int option);
+};
@@ -0,0 +1,184 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define CATSURV_HAVE_AVX2_KERNELS 1
+#endif
+
+/**
+ * Batch versions of the item response curves. Each kernel fills a whole array (many thetas for one item, or
+ * one theta for many items) with no per-element branches: exp overflow is absorbed by writing the logistic as
+ * 1 / (1 + exp(-x)), and the [eps, 1 - eps] clamping of Estimator::prob_ltm and GrmProb is a min/max.
+ *
+ * On x86 processors that support AVX2 and FMA the loops run four thetas at a time with a vectorized exp. The
+ * choice is made at run time, so the package does not need to be compiled with -mavx2 and falls back to the
+ * portable loop everywhere else. This header deliberately avoids Rcpp and GSL so the kernels can be built and
+ * benchmarked on their own.
+ */
+namespace kernels
+{
+	/**
+	 * The cube root of machine epsilon, matching the clamping in Estimator.cpp.
+	 */
+	const double eps = 6.0554544523933429e-06;
+
+	/**
+	 * out[i] = clamp(c + (1 - c) / (1 + exp(-x[i]))) with c = guessing[i * stride], so a stride of 0 applies one
+	 * guessing parameter to every element. out may alias x.
+	 */
+	inline void logistic_portable(const double *x, double *out, std::size_t n, const double *guessing,
+	                              std::size_t stride)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			const double c = guessing[i * stride];
+			double p = c + (1.0 - c) / (1.0 + std::exp(-x[i]));
+			out[i] = std::min(std::max(p, eps), 1.0 - eps);
+		}
+	}
+
+#ifdef CATSURV_HAVE_AVX2_KERNELS
+	/**
+	 * exp for four doubles: x = k ln2 + r with |r| <= ln2 / 2, a degree 12 Taylor polynomial for exp(r)
+	 * (relative error below 2e-16), and 2^k assembled in the exponent bits. Inputs are clamped to +-708,
+	 * which is harmless here because the result only ever enters 1 / (1 + exp(-x)).
+	 */
+	__attribute__((target("avx2,fma")))
+	inline __m256d exp_avx2(__m256d x)
+	{
+		x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(-708.0)), _mm256_set1_pd(708.0));
+
+		const __m256d k = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634)),
+		                                  _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256d r = _mm256_fnmadd_pd(k, _mm256_set1_pd(6.93145751953125e-1), x);
+		r = _mm256_fnmadd_pd(k, _mm256_set1_pd(1.42860682030941723212e-6), r);
+
+		__m256d p = _mm256_set1_pd(1.0 / 479001600.0);
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 39916800.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 3628800.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 362880.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 40320.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 5040.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 720.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 120.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 24.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0 / 6.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(0.5));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+		p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(1.0));
+
+		// k + 1023 sits in the low mantissa bits of (k + 1023 + 2^52); shifting it up makes it the exponent
+		const __m256d biased = _mm256_add_pd(k, _mm256_set1_pd(1023.0 + 4503599627370496.0));
+		const __m256d scale = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(biased), 52));
+		return _mm256_mul_pd(p, scale);
+	}
+
+	__attribute__((target("avx2,fma")))
+	inline void logistic_avx2(const double *x, double *out, std::size_t n, const double *guessing,
+	                          std::size_t stride)
+	{
+		const __m256d one = _mm256_set1_pd(1.0);
+		const __m256d low = _mm256_set1_pd(eps);
+		const __m256d high = _mm256_set1_pd(1.0 - eps);
+		const __m256d zero = _mm256_setzero_pd();
+		const __m256d shared_guess = _mm256_set1_pd(guessing[0]);
+
+		std::size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			const __m256d guess = stride == 0 ? shared_guess : _mm256_loadu_pd(guessing + i);
+			const __m256d e = exp_avx2(_mm256_sub_pd(zero, _mm256_loadu_pd(x + i)));
+			__m256d p = _mm256_fmadd_pd(_mm256_sub_pd(one, guess), _mm256_div_pd(one, _mm256_add_pd(one, e)), guess);
+			p = _mm256_min_pd(_mm256_max_pd(p, low), high);
+			_mm256_storeu_pd(out + i, p);
+		}
+		logistic_portable(x + i, out + i, n - i, guessing + i * stride, stride);
+	}
+#endif
+
+	/**
+	 * Whether the AVX2 path is used on this machine.
+	 */
+	inline bool simd_enabled()
+	{
+#ifdef CATSURV_HAVE_AVX2_KERNELS
+		static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+		return supported;
+#else
+		return false;
+#endif
+	}
+
+	inline void logistic(const double *x, double *out, std::size_t n, const double *guessing, std::size_t stride)
+	{
+#ifdef CATSURV_HAVE_AVX2_KERNELS
+		if (simd_enabled())
+		{
+			logistic_avx2(x, out, n, guessing, stride);
+			return;
+		}
+#endif
+		logistic_portable(x, out, n, guessing, stride);
+	}
+
+	inline void logistic(const double *x, double *out, std::size_t n, double guessing = 0.0)
+	{
+		logistic(x, out, n, &guessing, 0);
+	}
+
+	/**
+	 * P(answer = 1) of an ltm/tpm item at each of n thetas.
+	 */
+	inline void ltm_probability(const double *theta, std::size_t n, double difficulty, double discrimination,
+	                            double guessing, double *out)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			out[i] = difficulty + discrimination * theta[i];
+		}
+		logistic(out, out, n, guessing);
+	}
+
+	/**
+	 * P(answer = 1) of n ltm/tpm items at one theta. The items' parameters are read from contiguous arrays, as
+	 * laid out in the ItemBank.
+	 */
+	inline void ltm_probability_items(double theta, std::size_t n, const double *difficulty,
+	                                  const double *discrimination, const double *guessing, double *out)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			out[i] = difficulty[i] + discrimination[i] * theta;
+		}
+		logistic(out, out, n, guessing, 1);
+	}
+
+	/**
+	 * The cumulative grm boundary curves of one item at one theta: out[k] = P*(thresholds[k]).
+	 */
+	inline void grm_boundaries(double theta, double discrimination, const double *thresholds, std::size_t count,
+	                           double *out)
+	{
+		const double theta_desc = theta * discrimination;
+		for (std::size_t k = 0; k < count; ++k)
+		{
+			out[k] = thresholds[k] - theta_desc;
+		}
+		logistic(out, out, count);
+	}
+
+	/**
+	 * One grm boundary curve at each of n thetas.
+	 */
+	inline void grm_boundary(const double *theta, std::size_t n, double discrimination, double threshold, double *out)
+	{
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			out[i] = threshold - theta[i] * discrimination;
+		}
+		logistic(out, out, n);
+	}
+}
@@ -1,9 +1,16 @@
 #include "QuestionSet.h"
 
-QuestionSet::QuestionSet(Rcpp::S4 &cat_df) {
+QuestionSet::QuestionSet(Rcpp::S4 &cat_df) : QuestionSet(cat_df, std::make_shared<const ItemBank>(cat_df)) { }
+
+QuestionSet::QuestionSet(Rcpp::S4 &cat_df, std::shared_ptr<const ItemBank> itemBank)
+	: bank(itemBank),
+	  question_names(bank->question_names),
+	  difficulty(bank->difficulty),
+	  guessing(bank->guessing),
+	  discrimination(bank->discrimination),
+	  model(bank->model),
+	  modelType(bank->modelType) {
 	answers = Rcpp::as<std::vector<int> >(cat_df.slot("answers"));
-	guessing = Rcpp::as<std::vector<double> >(cat_df.slot("guessing"));
-	discrimination = Rcpp::as<std::vector<double> >(cat_df.slot("discrimination"));
 	
 	z = Rcpp::as<std::vector<double> >(cat_df.slot("z"));
 	z[0] = R::qnorm(z.at(0), 0.0, 1.0, 1, 0);
@@ -11,17 +18,6 @@ QuestionSet::QuestionSet(Rcpp::S4 &cat_df) {
 	
 	lowerBound = Rcpp::as<double >(cat_df.slot("lowerBound"));
 	upperBound = Rcpp::as<double >(cat_df.slot("upperBound"));
-	
-	Rcpp::NumericVector discrim_names = cat_df.slot("discrimination");
-  	Rcpp::CharacterVector names = discrim_names.names();
-  	question_names = Rcpp::as<std::vector<std::string> >(names);
-
-  	model = Rcpp::as<std::string >(cat_df.slot("model"));
-
-
-	for (auto item : (Rcpp::List) cat_df.slot("difficulty")) {
-		difficulty.push_back(Rcpp::as<std::vector<double> >(item));
-	}
 
 	reset_applicables();
 	reset_all_extreme();
@@ -160,11 +156,11 @@ void QuestionSet::reset_all_extreme()
     std::vector<bool> minAnswer_negDiscrim;
     std::vector<bool> maxAnswer_negDiscrim;
     
-    int min_response = ((model == "ltm") | (model == "tpm")) ? 0.0 : 1.0;
+    int min_response = ((modelType == ModelType::LTM) | (modelType == ModelType::TPM)) ? 0.0 : 1.0;
     
     
     for (auto i : applicable_rows) {
-        int max_response = ((model == "ltm") | (model == "tpm")) ? 1.0 : difficulty.at(i).size() + 1.0;
+        int max_response = ((modelType == ModelType::LTM) | (modelType == ModelType::TPM)) ? 1.0 : difficulty.at(i).size() + 1.0;
         
         if (discrimination.at(i) < 0.0 and answers.at(i) == min_response){
             minAnswer_negDiscrim.push_back(true); 
@@ -1,20 +1,25 @@
 #pragma once
 #include <Rcpp.h>
 #include <vector>
+#include <memory>
+#include "ItemBank.h"
 
 /**
- * Contains the various lists of values necessary for a Cat.
+ * Contains the various lists of values necessary for a Cat. The item parameters belong to a shared ItemBank;
+ * the members below alias it, so only the respondent's answers and the rows derived from them are per-Cat state.
  */
 struct QuestionSet {
-  std::vector<std::string> question_names;
-	std::vector<std::vector<double> > difficulty;
+	std::shared_ptr<const ItemBank> bank;
+
+  const std::vector<std::string> &question_names;
+	const ThresholdTable &difficulty;
 
 	std::vector<int> applicable_rows;
 	std::vector<int> nonapplicable_rows;
 	std::vector<int> skipped;
 	
-	std::vector<double> guessing;
-	std::vector<double> discrimination;
+	const std::vector<double> &guessing;
+	const std::vector<double> &discrimination;
 	std::vector<double> z;
 	//std::vector<double> zz;
 	
@@ -22,7 +27,8 @@ struct QuestionSet {
 	 * The user's answer to each question.
 	 */
 	std::vector<int> answers;
-	std::string model;
+	const std::string &model;
+	const ModelType &modelType;
 	/**
 	 * Keeping track of extreme answers for MLEEstimator.
 	 */	
@@ -35,6 +41,8 @@ struct QuestionSet {
 
 	QuestionSet(Rcpp::S4 &cat_df);
 
+	QuestionSet(Rcpp::S4 &cat_df, std::shared_ptr<const ItemBank> itemBank);
+
 	void reset_answers(Rcpp::DataFrame& responses, size_t row);
 	void reset_answer(size_t question, int answer);
 	void reset_answers(std::vector<int> const& source);
@@ -7,6 +7,30 @@
 
 using namespace Rcpp;
 
+// estimateThetasBatch
+List estimateThetasBatch(S4 catObj, IntegerMatrix responses, bool se);
+RcppExport SEXP _catSurv_estimateThetasBatch(SEXP catObjSEXP, SEXP responsesSEXP, SEXP seSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< S4 >::type catObj(catObjSEXP);
+    Rcpp::traits::input_parameter< IntegerMatrix >::type responses(responsesSEXP);
+    Rcpp::traits::input_parameter< bool >::type se(seSEXP);
+    rcpp_result_gen = Rcpp::wrap(estimateThetasBatch(catObj, responses, se));
+    return rcpp_result_gen;
+END_RCPP
+}
+// catInstrumentation
+List catInstrumentation(bool reset);
+RcppExport SEXP _catSurv_catInstrumentation(SEXP resetSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< bool >::type reset(resetSEXP);
+    rcpp_result_gen = Rcpp::wrap(catInstrumentation(reset));
+    return rcpp_result_gen;
+END_RCPP
+}
 // probability
 std::vector<double> probability(S4 catObj, double theta, int item);
 RcppExport SEXP _catSurv_probability(SEXP catObjSEXP, SEXP thetaSEXP, SEXP itemSEXP) {
@@ -155,13 +179,14 @@ BEGIN_RCPP
 END_RCPP
 }
 // selectItem
-List selectItem(S4 catObj);
-RcppExport SEXP _catSurv_selectItem(SEXP catObjSEXP) {
+List selectItem(S4 catObj, double timeBudget);
+RcppExport SEXP _catSurv_selectItem(SEXP catObjSEXP, SEXP timeBudgetSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< S4 >::type catObj(catObjSEXP);
-    rcpp_result_gen = Rcpp::wrap(selectItem(catObj));
+    Rcpp::traits::input_parameter< double >::type timeBudget(timeBudgetSEXP);
+    rcpp_result_gen = Rcpp::wrap(selectItem(catObj, timeBudget));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -224,3 +249,190 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// catSession
+SEXP catSession(S4 catObj, List options, SEXP bank);
+RcppExport SEXP _catSurv_catSession(SEXP catObjSEXP, SEXP optionsSEXP, SEXP bankSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< S4 >::type catObj(catObjSEXP);
+    Rcpp::traits::input_parameter< List >::type options(optionsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type bank(bankSEXP);
+    rcpp_result_gen = Rcpp::wrap(catSession(catObj, options, bank));
+    return rcpp_result_gen;
+END_RCPP
+}
+// catItemBank
+SEXP catItemBank(S4 catObj);
+RcppExport SEXP _catSurv_catItemBank(SEXP catObjSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< S4 >::type catObj(catObjSEXP);
+    rcpp_result_gen = Rcpp::wrap(catItemBank(catObj));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sessionStoreAnswer
+void sessionStoreAnswer(SEXP session, int item, int answer);
+RcppExport SEXP _catSurv_sessionStoreAnswer(SEXP sessionSEXP, SEXP itemSEXP, SEXP answerSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< int >::type item(itemSEXP);
+    Rcpp::traits::input_parameter< int >::type answer(answerSEXP);
+    sessionStoreAnswer(session, item, answer);
+    return R_NilValue;
+END_RCPP
+}
+// sessionAnswers
+std::vector<int> sessionAnswers(SEXP session);
+RcppExport SEXP _catSurv_sessionAnswers(SEXP sessionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    rcpp_result_gen = Rcpp::wrap(sessionAnswers(session));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sessionSelectItem
+List sessionSelectItem(SEXP session, double timeBudget);
+RcppExport SEXP _catSurv_sessionSelectItem(SEXP sessionSEXP, SEXP timeBudgetSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< double >::type timeBudget(timeBudgetSEXP);
+    rcpp_result_gen = Rcpp::wrap(sessionSelectItem(session, timeBudget));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sessionEstimateTheta
+double sessionEstimateTheta(SEXP session);
+RcppExport SEXP _catSurv_sessionEstimateTheta(SEXP sessionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    rcpp_result_gen = Rcpp::wrap(sessionEstimateTheta(session));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sessionEstimateSE
+double sessionEstimateSE(SEXP session);
+RcppExport SEXP _catSurv_sessionEstimateSE(SEXP sessionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    rcpp_result_gen = Rcpp::wrap(sessionEstimateSE(session));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sessionCheckStopRules
+bool sessionCheckStopRules(SEXP session);
+RcppExport SEXP _catSurv_sessionCheckStopRules(SEXP sessionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    rcpp_result_gen = Rcpp::wrap(sessionCheckStopRules(session));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sessionLookAhead
+List sessionLookAhead(SEXP session, int item);
+RcppExport SEXP _catSurv_sessionLookAhead(SEXP sessionSEXP, SEXP itemSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< int >::type item(itemSEXP);
+    rcpp_result_gen = Rcpp::wrap(sessionLookAhead(session, item));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sessionPrecompute
+void sessionPrecompute(SEXP session, int item);
+RcppExport SEXP _catSurv_sessionPrecompute(SEXP sessionSEXP, SEXP itemSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    Rcpp::traits::input_parameter< int >::type item(itemSEXP);
+    sessionPrecompute(session, item);
+    return R_NilValue;
+END_RCPP
+}
+// sessionNextItem
+int sessionNextItem(SEXP session);
+RcppExport SEXP _catSurv_sessionNextItem(SEXP sessionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type session(sessionSEXP);
+    rcpp_result_gen = Rcpp::wrap(sessionNextItem(session));
+    return rcpp_result_gen;
+END_RCPP
+}
+// simulateCatBatch
+List simulateCatBatch(S4 catObj, IntegerMatrix responses, NumericVector theta, bool sample, List options, int seed);
+RcppExport SEXP _catSurv_simulateCatBatch(SEXP catObjSEXP, SEXP responsesSEXP, SEXP thetaSEXP, SEXP sampleSEXP, SEXP optionsSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< S4 >::type catObj(catObjSEXP);
+    Rcpp::traits::input_parameter< IntegerMatrix >::type responses(responsesSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type theta(thetaSEXP);
+    Rcpp::traits::input_parameter< bool >::type sample(sampleSEXP);
+    Rcpp::traits::input_parameter< List >::type options(optionsSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(simulateCatBatch(catObj, responses, theta, sample, options, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
+// makeTreeNodes
+List makeTreeNodes(S4 catObj);
+RcppExport SEXP _catSurv_makeTreeNodes(SEXP catObjSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< S4 >::type catObj(catObjSEXP);
+    rcpp_result_gen = Rcpp::wrap(makeTreeNodes(catObj));
+    return rcpp_result_gen;
+END_RCPP
+}
+// treeTableBytes
+RawVector treeTableBytes(S4 catObj);
+RcppExport SEXP _catSurv_treeTableBytes(SEXP catObjSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< S4 >::type catObj(catObjSEXP);
+    rcpp_result_gen = Rcpp::wrap(treeTableBytes(catObj));
+    return rcpp_result_gen;
+END_RCPP
+}
+// treeTableLoad
+SEXP treeTableLoad(RawVector bytes);
+RcppExport SEXP _catSurv_treeTableLoad(SEXP bytesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< RawVector >::type bytes(bytesSEXP);
+    rcpp_result_gen = Rcpp::wrap(treeTableLoad(bytes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// treeNextItem
+int treeNextItem(SEXP tree, IntegerVector answers);
+RcppExport SEXP _catSurv_treeNextItem(SEXP treeSEXP, SEXP answersSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type tree(treeSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type answers(answersSEXP);
+    rcpp_result_gen = Rcpp::wrap(treeNextItem(tree, answers));
+    return rcpp_result_gen;
+END_RCPP
+}
@@ -9,4 +9,13 @@ struct Selection {
 	std::string name;
 	int item;
 	std::vector<std::string> question_names;
+	/**
+	 * Unanswered items that screening dropped before the criterion was computed.
+	 */
+	size_t pruned = 0;
+	/**
+	 * Whether the selector's deadline passed before every candidate was scored; questions and values then list
+	 * only the scored candidates.
+	 */
+	bool timedOut = false;
 };
\ No newline at end of file
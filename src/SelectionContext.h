@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include "Prior.h"
+
+class GridPosterior;
+
+/**
+ * What every candidate item of one selection round shares: the current estimate of theta, its standard error,
+ * the test information at that estimate, and the session's grid posterior (null with adaptive quadrature) with
+ * its integration weights.
+ *
+ * Each Selector builds the context once, before scoring the candidates in parallel, instead of letting every
+ * candidate re-estimate theta. Only the fields a criterion asks for are computed; the rest are left as NaN, so
+ * building the context never costs more than the criterion did before.
+ */
+struct SelectionContext {
+	enum Need : unsigned {
+		THETA = 1, SE = 2, TEST_INFO = 4, LIKELIHOOD_WEIGHTS = 8, POSTERIOR_WEIGHTS = 16
+	};
+
+	const Prior &prior;
+	double theta;
+	double se;
+	double testInfo;
+	const GridPosterior *posterior;
+
+	/**
+	 * GridPosterior::integrationWeights without and with the prior. They stay empty unless asked for on a session
+	 * with an active grid.
+	 */
+	std::vector<double> likelihoodWeights;
+	std::vector<double> posteriorWeights;
+};
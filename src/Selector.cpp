@@ -1,7 +1,97 @@
 #include "Selector.h"
+#include <algorithm>
+#include <cmath>
 
 /**
  * An abstract class that represents the various ways of selecting the next question.
  */
 Selector::Selector(QuestionSet &questions, Estimator &estimation, Prior &priorModel)
-		: questionSet(questions), estimator(estimation), prior(priorModel) {}
+		: questionSet(questions), estimator(estimation), prior(priorModel), mfiIndex(nullptr), screeningSize(0),
+		  hasDeadline(false) {}
+
+void Selector::setMFIIndex(const MFIIndex *index) {
+	mfiIndex = index;
+}
+
+void Selector::setScreeningSize(size_t n) {
+	screeningSize = n;
+}
+
+void Selector::setDeadline(std::chrono::steady_clock::time_point time) {
+	hasDeadline = true;
+	deadline = time;
+}
+
+void Selector::clearDeadline() {
+	hasDeadline = false;
+}
+
+void Selector::prioritize(const SelectionContext &context, Selection &selection) {
+	if (!hasDeadline) {
+		return;
+	}
+	const double theta = std::isnan(context.theta) ? estimator.estimateTheta(prior) : context.theta;
+	const std::vector<double> information = estimator.fisherInf(theta, selection.questions);
+
+	std::vector<size_t> order(selection.questions.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return information[a] > information[b];
+	});
+
+	std::vector<int> questions(order.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		questions[i] = selection.questions[order[i]];
+	}
+	selection.questions = questions;
+}
+
+void Selector::keepScored(Selection &selection, size_t scored) {
+	selection.timedOut = scored < selection.questions.size();
+
+	std::vector<size_t> order(scored);
+	for (size_t i = 0; i < scored; ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return selection.questions[a] < selection.questions[b];
+	});
+
+	std::vector<int> questions(scored);
+	std::vector<double> values(scored);
+	for (size_t i = 0; i < scored; ++i) {
+		questions[i] = selection.questions[order[i]];
+		values[i] = selection.values[order[i]];
+	}
+	selection.questions = questions;
+	selection.values = values;
+}
+
+std::vector<int> Selector::candidates(double theta, Selection &selection) {
+	const std::vector<int> &unanswered = questionSet.nonapplicable_rows;
+	if (screeningSize == 0 || unanswered.size() <= screeningSize) {
+		selection.pruned = 0;
+		return unanswered;
+	}
+
+	const std::vector<double> information = estimator.fisherInf(theta, unanswered);
+	std::vector<size_t> order(unanswered.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	// unanswered is in item order, so comparing positions breaks ties towards the lower item
+	std::nth_element(order.begin(), order.begin() + screeningSize, order.end(), [&](size_t a, size_t b) {
+		return information[a] > information[b] || (information[a] == information[b] && a < b);
+	});
+	order.resize(screeningSize);
+	std::sort(order.begin(), order.end());
+
+	std::vector<int> kept(screeningSize);
+	for (size_t i = 0; i < screeningSize; ++i) {
+		kept[i] = unanswered[order[i]];
+	}
+	selection.pruned = unanswered.size() - screeningSize;
+	return kept;
+}
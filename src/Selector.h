@@ -1,8 +1,12 @@
 #pragma once
 
+#include <chrono>
 #include "Selection.h"
 #include "QuestionSet.h"
 #include "Estimator.h"
+#include "MFIIndex.h"
+#include "ParallelUtil.h"
+#include "SelectionContext.h"
 
 enum class SelectionType {
 	NONE, EPV, MFI, MFII, MEI, MPWI, MLWI, KL, LKL, PKL, RANDOM
@@ -17,9 +21,77 @@ public:
 
 	Selector(QuestionSet &questions, Estimator &estimation, Prior &priorModel);
 
+	/**
+	 * Sessions created with the mfiResolution option share their bank's MFI ranking index with the selector. Only
+	 * MFI selection reads it.
+	 */
+	void setMFIIndex(const MFIIndex *index);
+
+	/**
+	 * With a screening size of n > 0, the EPV, MEI, MFII, KL, LKL, and PKL selectors compute their criterion only
+	 * for the n unanswered items with the most Fisher information at the current theta.
+	 */
+	void setScreeningSize(size_t n);
+
+	/**
+	 * The unanswered items the criterion is computed for: all of them, or the screeningSize most informative at
+	 * theta (ties going to the lower item), in item order. The number screened out is recorded in selection.pruned.
+	 * Public so that LookAheadSearch screens the items it searches the same way.
+	 */
+	std::vector<int> candidates(double theta, Selection &selection);
+
+	/**
+	 * Limits the time the EPV, MEI, MFII, KL, LKL, PKL, and (without a grid posterior) MPWI and MLWI selectors spend
+	 * scoring candidates, until clearDeadline(); see score().
+	 */
+	void setDeadline(std::chrono::steady_clock::time_point time);
+	void clearDeadline();
+
 protected:
+	/**
+	 * Under a deadline, reorders selection.questions by Fisher information at theta, most informative first, so
+	 * that score() reaches the likeliest choices first. theta is estimated if the context has none.
+	 */
+	void prioritize(const SelectionContext &context, Selection &selection);
+
+	/**
+	 * Runs worker, which writes the score of selection.questions[i] to selection.values[i], over every candidate.
+	 * Under a deadline, the candidates are scored a round of one per thread at a time, in the order prioritize()
+	 * left them, until the deadline passes; at least one round is always scored. Unscored candidates are then
+	 * dropped, selection.timedOut is set, and the rest are put back in item order.
+	 */
+	template<typename Worker>
+	void score(Selection &selection, Worker &worker)
+	{
+		const std::size_t count = selection.questions.size();
+		if (!hasDeadline) {
+			mpl::parallelFor(0, count, worker);
+			return;
+		}
+
+		const std::size_t round = mpl::threadCount();
+		std::size_t scored = 0;
+		while (scored < count) {
+			const std::size_t end = std::min(count, scored + round);
+			mpl::parallelFor(scored, end, worker);
+			scored = end;
+			if (std::chrono::steady_clock::now() >= deadline) {
+				break;
+			}
+		}
+		keepScored(selection, scored);
+	}
+
 	QuestionSet &questionSet;
 	Estimator &estimator;
 	Prior &prior;
+	const MFIIndex *mfiIndex;
+	size_t screeningSize;
+
+private:
+	void keepScored(Selection &selection, size_t scored);
+
+	bool hasDeadline;
+	std::chrono::steady_clock::time_point deadline;
 };
 
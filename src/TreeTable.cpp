@@ -0,0 +1,120 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include "TreeTable.h"
+
+namespace {
+
+const int32_t MAGIC = 0x54544143; // "CATT" in little-endian byte order
+const int32_t VERSION = 1;
+const size_t HEADER = 6;
+
+void put(std::vector<unsigned char> &bytes, int32_t value) {
+	const uint32_t bits = (uint32_t) value;
+	for (int shift = 0; shift < 32; shift += 8) {
+		bytes.push_back((unsigned char) (bits >> shift));
+	}
+}
+
+int32_t get(const std::vector<unsigned char> &bytes, size_t index) {
+	uint32_t bits = 0;
+	for (int k = 3; k >= 0; --k) {
+		bits = (bits << 8) | bytes[index * 4 + k];
+	}
+	return (int32_t) bits;
+}
+
+}
+
+const int32_t TreeTable::STOP;
+const int32_t TreeTable::NONE;
+
+TreeTable::TreeTable(const CatTree &tree, size_t items) : nodes(tree.getNodes().size()), width(0), items(items) {
+	const std::vector<CatTree::Node> &treeNodes = tree.getNodes();
+	for (const CatTree::Node &node : treeNodes) {
+		width = std::max(width, node.children.size());
+	}
+	// the first option after the skip is the lowest answer, the same for every item of a model
+	lowestAnswer = tree.responseOptions(treeNodes.at(0)).at(1);
+
+	table.assign(nodes * (width + 1), NONE);
+	for (size_t n = 0; n < nodes; ++n) {
+		int32_t *row = &table[n * (width + 1)];
+		row[0] = treeNodes[n].item;
+		std::copy(treeNodes[n].children.begin(), treeNodes[n].children.end(), row + 1);
+	}
+}
+
+TreeTable::TreeTable(const std::vector<unsigned char> &bytes) {
+	if (bytes.size() < HEADER * 4 || bytes.size() % 4 != 0 || get(bytes, 0) != MAGIC) {
+		Rcpp::stop("Not a catSurv tree.");
+	}
+	if (get(bytes, 1) != VERSION) {
+		Rcpp::stop("Unsupported catSurv tree version %d.", get(bytes, 1));
+	}
+	const int32_t nodeCount = get(bytes, 2), widthCount = get(bytes, 3), itemCount = get(bytes, 4);
+	if (nodeCount < 1 || widthCount < 1 || itemCount < 1 ||
+	    bytes.size() / 4 - HEADER != (size_t) nodeCount * ((size_t) widthCount + 1)) {
+		Rcpp::stop("The catSurv tree is truncated or corrupt.");
+	}
+	nodes = nodeCount;
+	width = widthCount;
+	items = itemCount;
+	lowestAnswer = get(bytes, 5);
+
+	table.resize(nodes * (width + 1));
+	for (size_t i = 0; i < table.size(); ++i) {
+		table[i] = get(bytes, HEADER + i);
+	}
+	// children come after their parents, which also rules out cycles
+	for (size_t n = 0; n < nodes; ++n) {
+		const int32_t *row = &table[n * (width + 1)];
+		bool valid = row[0] >= 0 && (size_t) row[0] < items;
+		for (size_t k = 1; k <= width; ++k) {
+			valid = valid && (row[k] == STOP || row[k] == NONE || ((size_t) row[k] > n && (size_t) row[k] < nodes));
+		}
+		if (!valid) {
+			Rcpp::stop("The catSurv tree is truncated or corrupt.");
+		}
+	}
+}
+
+std::vector<unsigned char> TreeTable::bytes() const {
+	std::vector<unsigned char> bytes;
+	bytes.reserve((HEADER + table.size()) * 4);
+	put(bytes, MAGIC);
+	put(bytes, VERSION);
+	put(bytes, (int32_t) nodes);
+	put(bytes, (int32_t) width);
+	put(bytes, (int32_t) items);
+	put(bytes, lowestAnswer);
+	for (int32_t value : table) {
+		put(bytes, value);
+	}
+	return bytes;
+}
+
+int TreeTable::next(const std::vector<int> &answers) const {
+	if (answers.size() != items) {
+		Rcpp::stop("The tree was built for %d items, not %d.", (int) items, (int) answers.size());
+	}
+	size_t node = 0;
+	while (true) {
+		const int32_t *row = &table[node * (width + 1)];
+		const int answer = answers[row[0]];
+		if (answer == NA_INTEGER) {
+			return row[0];
+		}
+		const long slot = answer == -1 ? 0 : (long) answer - lowestAnswer + 1;
+		if (slot < 0 || slot >= (long) width || row[slot + 1] == NONE) {
+			Rcpp::stop("%d is not a valid answer for question %d.", answer, row[0] + 1);
+		}
+		if (row[slot + 1] == STOP) {
+			return STOP;
+		}
+		node = row[slot + 1];
+	}
+}
+
+size_t TreeTable::getItems() const {
+	return items;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "CatTree.h"
+
+/**
+ * A CatTree in the form it is served in: one row per node, the item asked and, per response option, the row of the
+ * next node, all fixed-width so that a node is found by its id alone. next() walks it from the root along a
+ * respondent's answers, so serving an item costs one step per item already asked and no selection at all.
+ *
+ * The binary form, bytes(), is a header of six little-endian 32-bit integers (the magic number, the format version,
+ * the numbers of nodes, response options per node, and items, and the lowest non-skip answer) followed by, for every
+ * node, its item (0-indexed) and its children, the skip first. A child is a node id, STOP where the administration
+ * ends, or NONE past the last response option of the node's item.
+ */
+class TreeTable {
+public:
+	static const int32_t STOP = -1;
+	static const int32_t NONE = -2;
+
+	TreeTable(const CatTree &tree, size_t items);
+
+	/**
+	 * Reads the binary form, checking it is complete and every child is in range.
+	 */
+	explicit TreeTable(const std::vector<unsigned char> &bytes);
+
+	std::vector<unsigned char> bytes() const;
+
+	/**
+	 * The item (0-indexed) to ask after answers, one per item with NA_INTEGER for those not asked, or STOP if the
+	 * administration has ended. Answers to items the tree did not ask along the way are ignored.
+	 */
+	int next(const std::vector<int> &answers) const;
+
+	size_t getItems() const;
+
+private:
+	size_t nodes;
+	size_t width;
+	size_t items;
+	int32_t lowestAnswer;
+	/**
+	 * Row n is table[n * (width + 1)]: the item, then width children.
+	 */
+	std::vector<int32_t> table;
+};
@@ -3,7 +3,7 @@
 
 double WLEEstimator::ltm_estimateTheta(Prior prior){
   
-  integrableFunction W = [&](double theta) {
+  auto W = [&](double theta) {
     double B = 0.0;
     double I = 0.0;
     for (auto item : questionSet.applicable_rows) {
@@ -28,7 +28,7 @@ double WLEEstimator::ltm_estimateTheta(Prior prior){
 
 double WLEEstimator::ltm_estimateTheta(Prior prior, size_t question, int answer){
   
-  integrableFunction W = [&](double theta) {
+  auto W = [&](double theta) {
     double B = 0.0;
     double I = 0.0;
     for (auto item : questionSet.applicable_rows) {
@@ -66,7 +66,7 @@ double WLEEstimator::ltm_estimateTheta(Prior prior, size_t question, int answer)
 
 double WLEEstimator::gpcm_estimateTheta(Prior prior){
   
-  integrableFunction W = [&](double theta) {
+  auto W = [&](double theta) {
     double B = 0.0;
     double I = 0.0;
 
@@ -92,7 +92,7 @@ double WLEEstimator::gpcm_estimateTheta(Prior prior){
 
 double WLEEstimator::gpcm_estimateTheta(Prior prior, size_t question, int answer){
   
-  integrableFunction W = [&](double theta) {
+  auto W = [&](double theta) {
     double B = 0.0;
     double I = 0.0;
   
@@ -127,7 +127,7 @@ double WLEEstimator::gpcm_estimateTheta(Prior prior, size_t question, int answer
 }
 
 double WLEEstimator::grm_estimateTheta(Prior prior){
-  integrableFunction W = [&](double theta) {
+  auto W = [&](double theta) {
     double B = 0.0;
     double I = 0.0;
 
@@ -183,7 +183,7 @@ double WLEEstimator::grm_estimateTheta(Prior prior){
 
 double WLEEstimator::grm_estimateTheta(Prior prior, size_t question, int answer){
 
-  integrableFunction W = [&](double theta) {
+  auto W = [&](double theta) {
     double B = 0.0;
     double I = 0.0;
 
@@ -258,13 +258,13 @@ double WLEEstimator::grm_estimateTheta(Prior prior, size_t question, int answer)
 double WLEEstimator::estimateTheta(Prior prior) {
   double theta = 0.0;
 
-  if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
+  if ((questionSet.modelType == ModelType::LTM) | (questionSet.modelType == ModelType::TPM)) {
 	  theta = ltm_estimateTheta(prior);
 	}
-	if (questionSet.model == "grm") {
+	if (questionSet.modelType == ModelType::GRM) {
 	  theta = grm_estimateTheta(prior);
 	}
-	if (questionSet.model == "gpcm"){
+	if (questionSet.modelType == ModelType::GPCM){
 		theta = gpcm_estimateTheta(prior);
 	}
 	return theta;
@@ -274,13 +274,13 @@ double WLEEstimator::estimateTheta(Prior prior, size_t question, int answer)
 {
   double theta = 0.0;
 
-  if ((questionSet.model == "ltm") | (questionSet.model == "tpm")) {
+  if ((questionSet.modelType == ModelType::LTM) | (questionSet.modelType == ModelType::TPM)) {
     theta = ltm_estimateTheta(prior, question, answer);
   }
-  if (questionSet.model == "grm") {
+  if (questionSet.modelType == ModelType::GRM) {
     theta = grm_estimateTheta(prior, question, answer);
   }
-  if (questionSet.model == "gpcm"){
+  if (questionSet.modelType == ModelType::GPCM){
     theta = gpcm_estimateTheta(prior, question, answer);
   }
   
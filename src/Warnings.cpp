@@ -0,0 +1,51 @@
+#include <Rcpp.h>
+#include <map>
+#include <mutex>
+#include <thread>
+#include "Warnings.h"
+
+// the package is loaded, and this initialized, on R's main thread
+static const std::thread::id main_thread = std::this_thread::get_id();
+
+static std::mutex held_mutex;
+static std::map<std::string, unsigned long> held;
+
+static thread_local int suppressed = 0;
+
+warnings::Suppress::Suppress() {
+	++suppressed;
+}
+
+warnings::Suppress::~Suppress() {
+	--suppressed;
+}
+
+void warnings::warn(const std::string &message) {
+	if (suppressed > 0) {
+		return;
+	}
+	if (std::this_thread::get_id() == main_thread) {
+		Rcpp::Rcout << message << std::endl;
+		return;
+	}
+	std::lock_guard<std::mutex> lock(held_mutex);
+	++held[message];
+}
+
+void warnings::flush() {
+	if (std::this_thread::get_id() != main_thread) {
+		return;
+	}
+	std::map<std::string, unsigned long> pending;
+	{
+		std::lock_guard<std::mutex> lock(held_mutex);
+		pending.swap(held);
+	}
+	for (auto &warning : pending) {
+		Rcpp::Rcout << warning.first;
+		if (warning.second > 1) {
+			Rcpp::Rcout << " (" << warning.second << " times)";
+		}
+		Rcpp::Rcout << std::endl;
+	}
+}
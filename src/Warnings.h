@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+
+/**
+ * The warnings the engine prints to the R console. R may only be called from the main thread, so a warning raised
+ * on an RcppParallel worker is held back, and mpl::parallelFor prints the held warnings, each with the number of
+ * times it was raised, once the loop has finished.
+ */
+namespace warnings
+{
+	/**
+	 * Prints message at once on the main thread; on any other thread, holds it for flush().
+	 */
+	void warn(const std::string &message);
+
+	/**
+	 * Prints and clears the held warnings. On any other thread (a loop nested in a worker) it does nothing, leaving
+	 * them for the flush of the outermost loop.
+	 */
+	void flush();
+
+	/**
+	 * Discards the warnings raised on this thread while it is alive, e.g. while building Cats whose answers are
+	 * about to be replaced.
+	 */
+	class Suppress
+	{
+	public:
+		Suppress();
+		~Suppress();
+		Suppress(const Suppress &) = delete;
+		Suppress &operator=(const Suppress &) = delete;
+	};
+}
@@ -0,0 +1,94 @@
+#include <Rcpp.h>
+#include <RcppParallel.h>
+#include <memory>
+#include "Cat.h"
+#include "ParallelUtil.h"
+#include "Warnings.h"
+using namespace Rcpp;
+
+/**
+ * Scores the rows of a response matrix in blocks of consecutive rows. Each block has a Cat of its own, built on
+ * the main thread on one shared ItemBank, so a worker only loads answers into its Cat and estimates; the Cat's
+ * question set, grid posterior, and estimator are the block's scratch space, reused from row to row.
+ */
+struct BatchEstimate : public RcppParallel::Worker
+{
+	const RcppParallel::RMatrix<int> responses;
+	std::vector<std::unique_ptr<Cat> > &cats;
+	const bool se;
+	RcppParallel::RVector<double> theta;
+	RcppParallel::RVector<double> standardError;
+	mpl::WorkerStatus status;
+
+	BatchEstimate(const IntegerMatrix &responses, std::vector<std::unique_ptr<Cat> > &cats, bool se,
+	              NumericVector &theta, NumericVector &standardError)
+		: responses(responses)
+		, cats(cats)
+		, se(se)
+		, theta(theta)
+		, standardError(standardError)
+		{}
+
+	void operator()(std::size_t begin, std::size_t end)
+	{
+		for (std::size_t block = begin; block < end && !status.failed(); ++block) {
+			status.run([&]() { score(block); });
+		}
+	}
+
+	void score(std::size_t block)
+	{
+		Cat &cat = *cats[block];
+		const std::size_t rows = responses.nrow();
+		const std::size_t first = block * rows / cats.size();
+		const std::size_t last = (block + 1) * rows / cats.size();
+
+		std::vector<int> answers(responses.ncol());
+		for (std::size_t row = first; row < last; ++row) {
+			for (std::size_t j = 0; j < answers.size(); ++j) {
+				answers[j] = responses(row, j);
+			}
+			cat.resetAnswers(answers);
+			theta[row] = cat.estimateTheta();
+			if (se) {
+				standardError[row] = cat.estimateSE();
+			}
+		}
+	}
+};
+
+//' Estimates theta (and, if se is set, its standard error) for every row of an integer response matrix with one
+//' column per item of catObj.  Called by estimateThetas.
+//'
+//' @noRd
+// [[Rcpp::export]]
+List estimateThetasBatch(S4 catObj, IntegerMatrix responses, bool se = false) {
+	const std::size_t items = Rcpp::as<std::vector<int> >(catObj.slot("answers")).size();
+	if ((std::size_t) responses.ncol() != items) {
+		Rcpp::stop("Cat object not compatible with responses.");
+	}
+
+	const std::size_t rows = responses.nrow();
+	NumericVector theta(rows);
+	NumericVector standardError(se ? rows : 0);
+	if (rows == 0) {
+		return List::create(Named("theta") = theta, Named("SE") = standardError);
+	}
+
+	// a few blocks per thread, so that a thread finishing early can take another
+	const std::size_t blocks = std::min(rows, 4 * mpl::threadCount());
+	std::shared_ptr<const ItemBank> bank = std::make_shared<const ItemBank>(catObj);
+	std::vector<std::unique_ptr<Cat> > cats;
+	{
+		// the Cats start from catObj's answers, which every block replaces before estimating
+		warnings::Suppress suppress;
+		for (std::size_t block = 0; block < blocks; ++block) {
+			cats.emplace_back(new Cat(catObj, CatOptions(), bank));
+		}
+	}
+
+	BatchEstimate worker(responses, cats, se, theta, standardError);
+	mpl::parallelFor(0, blocks, worker);
+
+	return List::create(Named("theta") = theta, Named("SE") = standardError);
+}
@@ -8,11 +8,15 @@
 */
 
 /* .Call calls */
+extern SEXP _catSurv_catInstrumentation(SEXP);
+extern SEXP _catSurv_catItemBank(SEXP);
+extern SEXP _catSurv_catSession(SEXP, SEXP, SEXP);
 extern SEXP _catSurv_checkStopRules(SEXP);
 extern SEXP _catSurv_d1LL(SEXP, SEXP, SEXP);
 extern SEXP _catSurv_d2LL(SEXP, SEXP, SEXP);
 extern SEXP _catSurv_estimateSE(SEXP);
 extern SEXP _catSurv_estimateTheta(SEXP);
+extern SEXP _catSurv_estimateThetasBatch(SEXP, SEXP, SEXP);
 extern SEXP _catSurv_expectedKL(SEXP, SEXP);
 extern SEXP _catSurv_expectedObsInf(SEXP, SEXP);
 extern SEXP _catSurv_expectedPV(SEXP, SEXP);
@@ -21,32 +25,64 @@ extern SEXP _catSurv_fisherTestInfo(SEXP, SEXP);
 extern SEXP _catSurv_likelihood(SEXP, SEXP);
 extern SEXP _catSurv_likelihoodKL(SEXP, SEXP);
 extern SEXP _catSurv_lookAhead(SEXP, SEXP);
+extern SEXP _catSurv_makeTreeNodes(SEXP);
 extern SEXP _catSurv_obsInf(SEXP, SEXP, SEXP);
 extern SEXP _catSurv_posteriorKL(SEXP, SEXP);
 extern SEXP _catSurv_prior(SEXP, SEXP);
 extern SEXP _catSurv_probability(SEXP, SEXP, SEXP);
-extern SEXP _catSurv_selectItem(SEXP);
+extern SEXP _catSurv_selectItem(SEXP, SEXP);
+extern SEXP _catSurv_sessionAnswers(SEXP);
+extern SEXP _catSurv_sessionCheckStopRules(SEXP);
+extern SEXP _catSurv_sessionEstimateSE(SEXP);
+extern SEXP _catSurv_sessionEstimateTheta(SEXP);
+extern SEXP _catSurv_sessionLookAhead(SEXP, SEXP);
+extern SEXP _catSurv_sessionNextItem(SEXP);
+extern SEXP _catSurv_sessionPrecompute(SEXP, SEXP);
+extern SEXP _catSurv_sessionSelectItem(SEXP, SEXP);
+extern SEXP _catSurv_sessionStoreAnswer(SEXP, SEXP, SEXP);
+extern SEXP _catSurv_simulateCatBatch(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP _catSurv_treeNextItem(SEXP, SEXP);
+extern SEXP _catSurv_treeTableBytes(SEXP);
+extern SEXP _catSurv_treeTableLoad(SEXP);
 
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_catSurv_checkStopRules", (DL_FUNC) &_catSurv_checkStopRules, 1},
-    {"_catSurv_d1LL",           (DL_FUNC) &_catSurv_d1LL,           3},
-    {"_catSurv_d2LL",           (DL_FUNC) &_catSurv_d2LL,           3},
-    {"_catSurv_estimateSE",     (DL_FUNC) &_catSurv_estimateSE,     1},
-    {"_catSurv_estimateTheta",  (DL_FUNC) &_catSurv_estimateTheta,  1},
-    {"_catSurv_expectedKL",     (DL_FUNC) &_catSurv_expectedKL,     2},
-    {"_catSurv_expectedObsInf", (DL_FUNC) &_catSurv_expectedObsInf, 2},
-    {"_catSurv_expectedPV",     (DL_FUNC) &_catSurv_expectedPV,     2},
-    {"_catSurv_fisherInf",      (DL_FUNC) &_catSurv_fisherInf,      3},
-    {"_catSurv_fisherTestInfo", (DL_FUNC) &_catSurv_fisherTestInfo, 2},
-    {"_catSurv_likelihood",     (DL_FUNC) &_catSurv_likelihood,     2},
-    {"_catSurv_likelihoodKL",   (DL_FUNC) &_catSurv_likelihoodKL,   2},
-    {"_catSurv_lookAhead",      (DL_FUNC) &_catSurv_lookAhead,      2},
-    {"_catSurv_obsInf",         (DL_FUNC) &_catSurv_obsInf,         3},
-    {"_catSurv_posteriorKL",    (DL_FUNC) &_catSurv_posteriorKL,    2},
-    {"_catSurv_prior",          (DL_FUNC) &_catSurv_prior,          2},
-    {"_catSurv_probability",    (DL_FUNC) &_catSurv_probability,    3},
-    {"_catSurv_selectItem",     (DL_FUNC) &_catSurv_selectItem,     1},
+    {"_catSurv_catInstrumentation",    (DL_FUNC) &_catSurv_catInstrumentation,    1},
+    {"_catSurv_catItemBank",           (DL_FUNC) &_catSurv_catItemBank,           1},
+    {"_catSurv_catSession",            (DL_FUNC) &_catSurv_catSession,            3},
+    {"_catSurv_checkStopRules",        (DL_FUNC) &_catSurv_checkStopRules,        1},
+    {"_catSurv_d1LL",                  (DL_FUNC) &_catSurv_d1LL,                  3},
+    {"_catSurv_d2LL",                  (DL_FUNC) &_catSurv_d2LL,                  3},
+    {"_catSurv_estimateSE",            (DL_FUNC) &_catSurv_estimateSE,            1},
+    {"_catSurv_estimateTheta",         (DL_FUNC) &_catSurv_estimateTheta,         1},
+    {"_catSurv_estimateThetasBatch",   (DL_FUNC) &_catSurv_estimateThetasBatch,   3},
+    {"_catSurv_expectedKL",            (DL_FUNC) &_catSurv_expectedKL,            2},
+    {"_catSurv_expectedObsInf",        (DL_FUNC) &_catSurv_expectedObsInf,        2},
+    {"_catSurv_expectedPV",            (DL_FUNC) &_catSurv_expectedPV,            2},
+    {"_catSurv_fisherInf",             (DL_FUNC) &_catSurv_fisherInf,             3},
+    {"_catSurv_fisherTestInfo",        (DL_FUNC) &_catSurv_fisherTestInfo,        2},
+    {"_catSurv_likelihood",            (DL_FUNC) &_catSurv_likelihood,            2},
+    {"_catSurv_likelihoodKL",          (DL_FUNC) &_catSurv_likelihoodKL,          2},
+    {"_catSurv_lookAhead",             (DL_FUNC) &_catSurv_lookAhead,             2},
+    {"_catSurv_makeTreeNodes",         (DL_FUNC) &_catSurv_makeTreeNodes,         1},
+    {"_catSurv_obsInf",                (DL_FUNC) &_catSurv_obsInf,                3},
+    {"_catSurv_posteriorKL",           (DL_FUNC) &_catSurv_posteriorKL,           2},
+    {"_catSurv_prior",                 (DL_FUNC) &_catSurv_prior,                 2},
+    {"_catSurv_probability",           (DL_FUNC) &_catSurv_probability,           3},
+    {"_catSurv_selectItem",            (DL_FUNC) &_catSurv_selectItem,            2},
+    {"_catSurv_sessionAnswers",        (DL_FUNC) &_catSurv_sessionAnswers,        1},
+    {"_catSurv_sessionCheckStopRules", (DL_FUNC) &_catSurv_sessionCheckStopRules, 1},
+    {"_catSurv_sessionEstimateSE",     (DL_FUNC) &_catSurv_sessionEstimateSE,     1},
+    {"_catSurv_sessionEstimateTheta",  (DL_FUNC) &_catSurv_sessionEstimateTheta,  1},
+    {"_catSurv_sessionLookAhead",      (DL_FUNC) &_catSurv_sessionLookAhead,      2},
+    {"_catSurv_sessionNextItem",       (DL_FUNC) &_catSurv_sessionNextItem,       1},
+    {"_catSurv_sessionPrecompute",     (DL_FUNC) &_catSurv_sessionPrecompute,     2},
+    {"_catSurv_sessionSelectItem",     (DL_FUNC) &_catSurv_sessionSelectItem,     2},
+    {"_catSurv_sessionStoreAnswer",    (DL_FUNC) &_catSurv_sessionStoreAnswer,    3},
+    {"_catSurv_simulateCatBatch",      (DL_FUNC) &_catSurv_simulateCatBatch,      6},
+    {"_catSurv_treeNextItem",          (DL_FUNC) &_catSurv_treeNextItem,          2},
+    {"_catSurv_treeTableBytes",        (DL_FUNC) &_catSurv_treeTableBytes,        1},
+    {"_catSurv_treeTableLoad",         (DL_FUNC) &_catSurv_treeTableLoad,         1},
     {NULL, NULL, 0}
 };
 
@@ -0,0 +1,58 @@
+#include <Rcpp.h>
+#include "Instrumentation.h"
+using namespace Rcpp;
+
+std::atomic<unsigned long> instrumentation::workspaceAllocations(0);
+std::atomic<unsigned long> instrumentation::workspaceAllocationsAvoided(0);
+std::atomic<unsigned long> instrumentation::precomputedHits(0);
+std::atomic<unsigned long> instrumentation::precomputedMisses(0);
+
+void instrumentation::reset() {
+	workspaceAllocations = 0;
+	workspaceAllocationsAvoided = 0;
+	precomputedHits = 0;
+	precomputedMisses = 0;
+}
+
+//' Engine Instrumentation
+//'
+//' Reports counters kept by the compiled code across all calls in the current R process.
+//'
+//' @param reset Logical indicating whether the counters should be set back to zero after they are read
+//'
+//' @return A named list with the elements:
+//' \itemize{
+//' \item \code{workspaceAllocations}: the number of integration workspaces allocated.
+//' \item \code{workspaceAllocationsAvoided}: the number of adaptive integrals that reused the workspace of their thread instead of allocating one.
+//' \item \code{precomputedHits}: the number of \code{sessionNextItem} calls answered from a selection made by \code{sessionPrecompute}.
+//' \item \code{precomputedMisses}: the number of \code{sessionNextItem} calls that had to select the item on demand.
+//' }
+//'
+//' @details Adaptive integration needs scratch space for its subintervals.  Each thread, including the worker threads that
+//' score items in parallel during item selection, keeps the workspaces it has used and hands them to its next integral, so after
+//' the first few integrals selection runs without allocating memory.  The counters show how often that happened.
+//'
+//' @examples
+//'## Loading ltm Cat object
+//'data(ltm_cat)
+//'
+//'catInstrumentation(reset = TRUE)
+//'ltm_cat@selection <- "KL"
+//'selectItem(ltm_cat)
+//'catInstrumentation()
+//'
+//' @seealso \code{\link{selectItem}}, \code{\link{catSession}}
+//'
+//' @name catInstrumentation
+//' @export
+// [[Rcpp::export]]
+List catInstrumentation(bool reset = false) {
+	List counters = List::create(Named("workspaceAllocations") = (double) instrumentation::workspaceAllocations.load(),
+	                             Named("workspaceAllocationsAvoided") = (double) instrumentation::workspaceAllocationsAvoided.load(),
+	                             Named("precomputedHits") = (double) instrumentation::precomputedHits.load(),
+	                             Named("precomputedMisses") = (double) instrumentation::precomputedMisses.load());
+	if (reset) {
+		instrumentation::reset();
+	}
+	return counters;
+}
@@ -665,6 +665,7 @@ double expectedPV(S4 catObj, int item) {
 //' Selects the next item in the question set to be administered to respondent based on the specified selection method.
 //' 
 //' @param catObj An object of class \code{Cat}
+//' @param timeBudget The time, in milliseconds, the selection criterion may spend scoring items.  If \code{NA} (the default), every item is scored.  See Details.
 //'
 //' @return The function \code{selectItem} returns a list with three elements:
 //'  
@@ -712,6 +713,13 @@ double expectedPV(S4 catObj, int item) {
 //' A random number generator is used when the \code{selection}
 //' slot is \code{"RANDOM"}.
 //' 
+//' With a \code{timeBudget}, the \code{"EPV"}, \code{"MEI"}, \code{"MFII"}, \code{"KL"}, \code{"LKL"}, \code{"PKL"}, \code{"MPWI"}, and \code{"MLWI"} criteria
+//' score the unasked items in order of their Fisher information at the current estimate of theta, a few at a time, and stop once the budget is spent.
+//' At least the first few items are always scored, so the call may run somewhat over the budget, and the item selected is the best of those scored.
+//' The \code{estimates} then list only the scored items, and the returned list gains the elements \code{timedOut}, whether any item was left unscored,
+//' and \code{scored}, the number of items scored.  The other criteria, and the \code{"MPWI"} and \code{"MLWI"} criteria on a session with a fixed quadrature rule,
+//' are fast enough that they always score every item.
+//' 
 //' @references
 //' 
 //' van der Linden, Wim J. 1998. "Bayesian Item Selection Criteria for Adaptive Testing." Psychometrika
@@ -788,8 +796,8 @@ double expectedPV(S4 catObj, int item) {
 //'  
 //' @export
 // [[Rcpp::export]]
-List selectItem(S4 catObj) {
-  return Cat(catObj).selectItem();
+List selectItem(S4 catObj, double timeBudget = NA_REAL) {
+  return Cat(catObj).selectItem(timeBudget);
 }
 
 //' Expected Kullback-Leibler Information
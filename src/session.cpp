@@ -0,0 +1,257 @@
+#include <Rcpp.h>
+#include "Cat.h"
+#include "Precomputation.h"
+using namespace Rcpp;
+
+/**
+ * Persistent sessions. The functions in main.cpp rebuild a C++ Cat from the S4 object on every call, which
+ * re-reads every slot and re-runs the estimator and selector factories. A session builds the Cat once and hands
+ * R an external pointer to it; afterwards only the changed answer crosses the R boundary.
+ */
+
+/**
+ * What a catSession points to. The precomputation is declared last so that it is destroyed, and its thread
+ * joined, before the Cat it reads.
+ */
+struct Session {
+	std::unique_ptr<Cat> cat;
+	Precomputation precomputation;
+
+	explicit Session(Cat *cat) : cat(cat), precomputation(*cat) { }
+};
+
+/**
+ * Every catSurv handle is an external pointer, so each is tagged with its class when created and checked against it
+ * before the cast.
+ */
+static Session &sessionOf(SEXP session) {
+	if (TYPEOF(session) != EXTPTRSXP || R_ExternalPtrTag(session) != Rf_install("catSession")) {
+		Rcpp::stop("session must be a catSession, as returned by catSession().");
+	}
+	XPtr<Session> ptr(session);
+	if (ptr.get() == nullptr) {
+		Rcpp::stop("The catSession is no longer valid (sessions cannot be saved and reloaded). Create a new one with catSession().");
+	}
+	return *ptr;
+}
+
+static Cat &sessionCat(SEXP session) {
+	return *sessionOf(session).cat;
+}
+
+static std::shared_ptr<const ItemBank> &sessionItemBank(SEXP bank) {
+	if (TYPEOF(bank) != EXTPTRSXP || R_ExternalPtrTag(bank) != Rf_install("catItemBank")) {
+		Rcpp::stop("bank must be a catItemBank, as returned by catItemBank().");
+	}
+	XPtr<std::shared_ptr<const ItemBank> > ptr(bank);
+	if (ptr.get() == nullptr) {
+		Rcpp::stop("The catItemBank is no longer valid (item banks cannot be saved and reloaded). Create a new one with catItemBank().");
+	}
+	return *ptr;
+}
+
+//' Persistent Cat Sessions
+//'
+//' Creates a native session from a \code{Cat} object and administers items against it without rebuilding the \code{Cat} on every call.
+//'
+//' @param catObj An object of class \code{Cat}
+//' @param options A named list of engine options that are not slots of the \code{Cat} class.  See Details.
+//' @param bank An object of class \code{catItemBank}, as returned by \code{catItemBank}, to share among sessions.  If \code{NULL}, the session gets its own copy of the item parameters.
+//' @param session An object of class \code{catSession}, as returned by \code{catSession}
+//' @param item An integer indicating the index of the question item
+//' @param answer An integer indicating the response to \code{item}.  Use \code{-1} for a skipped item and \code{NA} to retract an answer.
+//' @param timeBudget The time, in milliseconds, item selection may spend scoring items, as for \code{\link{selectItem}}.
+//'
+//' @return The function \code{catSession} returns an object of class \code{catSession}, an external pointer to the compiled \code{Cat}.
+//'
+//' The function \code{catItemBank} returns an object of class \code{catItemBank}, an external pointer to the compiled item parameters of \code{catObj}.
+//'
+//' The function \code{sessionStoreAnswer} updates the session in place and returns \code{NULL} invisibly.
+//'
+//' The function \code{sessionAnswers} returns the \code{answers} currently stored in the session.
+//'
+//' The functions \code{sessionSelectItem}, \code{sessionEstimateTheta}, \code{sessionEstimateSE}, \code{sessionCheckStopRules},
+//' and \code{sessionLookAhead} return the same values as \code{\link{selectItem}}, \code{\link{estimateTheta}}, \code{\link{estimateSE}},
+//' \code{\link{checkStopRules}}, and \code{\link{lookAhead}} would for a \code{Cat} object holding the session's answers.
+//'
+//' The function \code{sessionPrecompute} starts selecting in the background and returns \code{NULL} invisibly.  The function \code{sessionNextItem}
+//' returns the index of the item that should be asked next, the \code{next_item} that \code{sessionSelectItem} would return.
+//'
+//' @details Every exported function that takes a \code{Cat} object converts it to a compiled object before doing any work.
+//' In a live survey, where \code{selectItem}, \code{storeAnswer}, and \code{checkStopRules} are called for every item,
+//' that conversion is paid several times per response.  A session performs it once, keeps the question set, estimator, and selector in
+//' compiled code, and only transfers the answer that changed.
+//'
+//' A session is a snapshot of \code{catObj} at the time of creation: later changes to \code{catObj} are not reflected in the session.
+//' Sessions live only as long as the R process and cannot be saved with \code{save} or \code{saveRDS}.
+//'
+//' The item parameters (\code{discrimination}, \code{guessing}, \code{difficulty}, and \code{model}) are read-only once compiled.  \code{catItemBank}
+//' compiles them once so that any number of sessions, each holding only its own answers, can be created on top of them with the \code{bank} argument;
+//' the probability tables of fixed quadrature rules are then also computed once per bank.  The item parameters of \code{catObj} must match those of \code{bank}.
+//'
+//' While a respondent reads an item, \code{sessionPrecompute} selects on a background thread the item that should follow each response to it,
+//' the skip included, starting with the responses that are likeliest at the current estimate of theta.  Once the answer is stored, \code{sessionNextItem}
+//' returns the item selected for it without selecting again.  If the answers have otherwise changed, or the background thread has not reached that response,
+//' \code{sessionNextItem} selects the item itself.  Storing an answer stops the background thread after the response it is working on, though never before the likeliest, and
+//' \code{\link{catInstrumentation}} counts how often the precomputed item was used.  Precomputation is not available with \code{"RANDOM"} selection
+//' or with the \code{lookAheadDepth} option.
+//'
+//' The following \code{options} are recognized:
+//' \itemize{
+//' \item \code{quadrature}: how the integrals of \code{"EAP"} estimation are evaluated.  \code{"ADAPTIVE"} (the default) uses
+//' adaptive Gauss-Kronrod quadrature, as the functions taking a \code{Cat} object do.  \code{"LEGENDRE"}, \code{"HERMITE"}, and \code{"GRID"}
+//' use a fixed Gauss-Legendre rule, a Gauss-Hermite rule rescaled to the bounds, or equally spaced points over \code{lowerBound} to \code{upperBound}.
+//' A fixed rule evaluates the posterior once per node and obtains the estimate, its standard error, and the normalizing constant from
+//' that single pass, which is considerably faster than adaptive integration at a small loss of precision.
+//' The session also keeps the log-likelihood of the answered items on those nodes, updating it as answers are stored or retracted,
+//' so \code{"EAP"} estimation and the \code{"MPWI"}, \code{"MLWI"}, \code{"LKL"}, and \code{"PKL"} selection criteria no longer revisit every answered item.
+//' \item \code{quadraturePoints}: the number of nodes of a fixed rule, between 2 and 1000 (at most 150 for \code{"HERMITE"}).  Defaults to 61.
+//' \item \code{mfiResolution}: if set, \code{"MFI"} selection uses a ranking of the items by Fisher information, built once per item bank
+//' over cells of this width between \code{lowerBound} and \code{upperBound}.  Within a cell, items are ranked by an upper bound on their information,
+//' and only items whose bound exceeds the best information found so far are scored, so the selected item is the one full scoring would choose.
+//' The \code{estimates} returned by \code{sessionSelectItem} then list only the scored items.  Smaller cells give tighter bounds, and fewer items scored, at the cost of a larger index.
+//' \item \code{screeningSize}: if set, the \code{"EPV"}, \code{"MEI"}, \code{"MFII"}, \code{"KL"}, \code{"LKL"}, and \code{"PKL"} criteria are computed
+//' only for this many unanswered items, those with the most Fisher information at the current estimate of theta.  The remaining items are not scored,
+//' and the list returned by \code{sessionSelectItem} gains an element \code{pruned} giving their number.  Screening trades exactness for speed:
+//' the item selected is the best of the screened items, which is usually, but not necessarily, the item full scoring would choose.
+//' \item \code{lookAheadDepth}: if set, items are selected by looking this many items ahead, the candidate included.  Each unanswered item is scored
+//' by the standard error expected after it and \code{lookAheadDepth - 1} further items, each chosen to minimize the same expectation, with every
+//' response weighted by its probability at the estimate of theta on its branch.  The item with the smallest expected standard error is selected,
+//' and the list returned by \code{sessionSelectItem} gains the elements \code{nodesExpanded} and \code{nodesPruned}, the response branches that were searched
+//' and those that were cut by \code{lookAheadTolerance}.  The search grows with the number of items and response options raised to the depth, so
+//' \code{screeningSize}, which applies at every level, and \code{lookAheadTolerance} keep larger depths affordable.
+//' \item \code{lookAheadTolerance}: a response branch whose probability times its standard error (the most that searching it could lower the expected standard error,
+//' which is never negative) is below this value is scored by its standard error instead of being searched further.  Searching can also raise a branch's score, since
+//' MLE, WLE, and MAP standard errors can grow with further answers, so with those estimators a pruned branch may be scored below what the full search would give.
+//' Defaults to 0, which searches every branch.  The search ignores the \code{timeBudget} of \code{sessionSelectItem}.
+//' }
+//'
+//' @examples
+//'## Loading ltm Cat object
+//'data(ltm_cat)
+//'
+//'## Administer items through a session
+//'session <- catSession(ltm_cat)
+//'item <- sessionSelectItem(session)$next_item
+//'sessionStoreAnswer(session, item, 1)
+//'sessionEstimateTheta(session)
+//'sessionEstimateSE(session)
+//'sessionCheckStopRules(session)
+//'
+//'## Many respondents sharing one copy of the item parameters
+//'bank <- catItemBank(ltm_cat)
+//'respondents <- lapply(1:3, function(i) catSession(ltm_cat, bank = bank))
+//'
+//'## Gauss-Legendre quadrature for EAP estimation
+//'fastSession <- catSession(ltm_cat, options = list(quadrature = "LEGENDRE", quadraturePoints = 41))
+//'sessionStoreAnswer(fastSession, item, 1)
+//'sessionEstimateTheta(fastSession)
+//'
+//'## What should be asked next for every possible response to the next item
+//'sessionLookAhead(session, sessionSelectItem(session)$next_item)
+//'
+//'## Select the item to follow every response while the respondent reads the next item
+//'item <- sessionSelectItem(session)$next_item
+//'sessionPrecompute(session, item)
+//'sessionStoreAnswer(session, item, 0)
+//'sessionNextItem(session)
+//'
+//' @seealso \code{\link{selectItem}}, \code{\link{storeAnswer}}, \code{\link{checkStopRules}}
+//'
+//' @note This function is to allow users to access the internal functions of the package. During item selection, all calculations are done in compiled \code{C++} code.
+//'
+//' @name catSession
+//' @export
+// [[Rcpp::export]]
+SEXP catSession(S4 catObj, List options = List::create(), SEXP bank = R_NilValue) {
+	CatOptions catOptions(options);
+	Cat *cat;
+	if (Rf_isNull(bank)) {
+		cat = new Cat(catObj, catOptions);
+	} else {
+		std::shared_ptr<const ItemBank> &itemBank = sessionItemBank(bank);
+		if (!itemBank->matches(catObj)) {
+			Rcpp::stop("The item parameters of catObj do not match those of bank.");
+		}
+		cat = new Cat(catObj, catOptions, itemBank);
+	}
+	XPtr<Session> ptr(new Session(cat), true, Rf_install("catSession"), R_NilValue);
+	ptr.attr("class") = "catSession";
+	return ptr;
+}
+
+//' @rdname catSession
+//' @export
+// [[Rcpp::export]]
+SEXP catItemBank(S4 catObj) {
+	XPtr<std::shared_ptr<const ItemBank> > ptr(new std::shared_ptr<const ItemBank>(std::make_shared<const ItemBank>(catObj)),
+	                                           true, Rf_install("catItemBank"), R_NilValue);
+	ptr.attr("class") = "catItemBank";
+	return ptr;
+}
+
+//' @rdname catSession
+//' @export
+// [[Rcpp::export]]
+void sessionStoreAnswer(SEXP session, int item, int answer) {
+	Session &state = sessionOf(session);
+	state.cat->storeAnswer(item - 1, answer);
+	// the options not yet selected can no longer be asked for
+	state.precomputation.cancel();
+}
+
+//' @rdname catSession
+//' @export
+// [[Rcpp::export]]
+std::vector<int> sessionAnswers(SEXP session) {
+	return sessionCat(session).getAnswers();
+}
+
+//' @rdname catSession
+//' @export
+// [[Rcpp::export]]
+List sessionSelectItem(SEXP session, double timeBudget = NA_REAL) {
+	return sessionCat(session).selectItem(timeBudget);
+}
+
+//' @rdname catSession
+//' @export
+// [[Rcpp::export]]
+double sessionEstimateTheta(SEXP session) {
+	return sessionCat(session).estimateTheta();
+}
+
+//' @rdname catSession
+//' @export
+// [[Rcpp::export]]
+double sessionEstimateSE(SEXP session) {
+	return sessionCat(session).estimateSE();
+}
+
+//' @rdname catSession
+//' @export
+// [[Rcpp::export]]
+bool sessionCheckStopRules(SEXP session) {
+	return sessionCat(session).checkStopRules();
+}
+
+//' @rdname catSession
+//' @export
+// [[Rcpp::export]]
+List sessionLookAhead(SEXP session, int item) {
+	return sessionCat(session).lookAhead(item - 1);
+}
+
+//' @rdname catSession
+//' @export
+// [[Rcpp::export]]
+void sessionPrecompute(SEXP session, int item) {
+	sessionOf(session).precomputation.start(item - 1);
+}
+
+//' @rdname catSession
+//' @export
+// [[Rcpp::export]]
+int sessionNextItem(SEXP session) {
+	return sessionOf(session).precomputation.nextItem() + 1;
+}
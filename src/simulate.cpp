@@ -0,0 +1,220 @@
+#include <Rcpp.h>
+#include <RcppParallel.h>
+#include <algorithm>
+#include <memory>
+#include <numeric>
+#include <random>
+#include "Cat.h"
+#include "ItemTables.h"
+#include "ParallelUtil.h"
+#include "Warnings.h"
+using namespace Rcpp;
+
+/**
+ * Runs complete adaptive administrations, one per respondent, in blocks of consecutive respondents. As in batch
+ * scoring, each block owns a Cat built on the main thread on one shared ItemBank and resets it between respondents,
+ * so a worker selects, stores answers, and checks the stop rules without crossing the R boundary.
+ *
+ * A respondent's answers are read from a row of the response matrix or, when sample is set, drawn from the model
+ * at the respondent's true theta. Every random draw (those answers, RANDOM selection, and the random item given
+ * when a selector fails) comes from a generator seeded with the seed and the respondent's row, so a run gives the
+ * same administrations whatever the number of threads.
+ */
+struct Simulation : public RcppParallel::Worker
+{
+	const RcppParallel::RMatrix<int> responses;
+	const RcppParallel::RVector<double> trueTheta;
+	std::vector<std::unique_ptr<Cat> > &cats;
+	const std::size_t respondents;
+	const bool sample;
+	const bool random;
+	const int seed;
+	RcppParallel::RVector<double> theta;
+	RcppParallel::RVector<double> standardError;
+	RcppParallel::RVector<int> length;
+	RcppParallel::RVector<double> info;
+	std::vector<std::vector<int> > &items;
+	mpl::WorkerStatus status;
+
+	Simulation(const IntegerMatrix &responses, const NumericVector &trueTheta, std::vector<std::unique_ptr<Cat> > &cats,
+	           std::size_t respondents, bool sample, bool random, int seed, NumericVector &theta,
+	           NumericVector &standardError, IntegerVector &length, NumericVector &info,
+	           std::vector<std::vector<int> > &items)
+		: responses(responses)
+		, trueTheta(trueTheta)
+		, cats(cats)
+		, respondents(respondents)
+		, sample(sample)
+		, random(random)
+		, seed(seed)
+		, theta(theta)
+		, standardError(standardError)
+		, length(length)
+		, info(info)
+		, items(items)
+		{}
+
+	void operator()(std::size_t begin, std::size_t end)
+	{
+		for (std::size_t block = begin; block < end && !status.failed(); ++block) {
+			status.run([&]() { simulate(block); });
+		}
+	}
+
+	void simulate(std::size_t block)
+	{
+		Cat &cat = *cats[block];
+		const std::size_t first = block * respondents / cats.size();
+		const std::size_t last = (block + 1) * respondents / cats.size();
+		for (std::size_t row = first; row < last && !status.failed(); ++row) {
+			administer(cat, row);
+		}
+	}
+
+	void administer(Cat &cat, std::size_t row)
+	{
+		std::seed_seq sequence{seed, (int) row};
+		std::mt19937 engine(sequence);
+
+		const std::size_t questions = cat.getItemBank()->size();
+		cat.resetAnswers(std::vector<int>(questions, NA_INTEGER));
+		std::vector<int> unanswered(questions);
+		std::iota(unanswered.begin(), unanswered.end(), 0);
+
+		std::vector<int> &administered = items[row];
+		while (!unanswered.empty()) {
+			const int item = select(cat, unanswered, engine);
+			unanswered.erase(std::find(unanswered.begin(), unanswered.end(), item));
+			cat.storeAnswer(item, answer(cat, row, item, engine));
+			administered.push_back(item + 1);
+			if (cat.checkStopRules()) {
+				break;
+			}
+		}
+
+		try {
+			theta[row] = cat.estimateTheta();
+			standardError[row] = cat.estimateSE();
+		} catch (const std::exception &e) {
+			fallBack(cat, row, e);
+		}
+		info[row] = cat.fisherTestInfo(trueTheta.length() > 0 ? trueTheta[row] : theta[row]);
+		length[row] = (int) administered.size();
+	}
+
+	/**
+	 * As simulateThetas did in R, a final estimate that fails is made again by EAP, and is NA only if the estimator
+	 * was EAP already or EAP fails too.
+	 */
+	void fallBack(Cat &cat, std::size_t row, const std::exception &error)
+	{
+		theta[row] = NA_REAL;
+		standardError[row] = NA_REAL;
+		if (cat.getEstimationType() == EstimationType::EAP) {
+			warnings::warn(std::string("Warning: theta could not be estimated for a simulated respondent (") + error.what() + ").");
+			return;
+		}
+		warnings::warn(std::string("Warning: theta could not be estimated for a simulated respondent (") + error.what() + "); EAP was used instead.");
+		try {
+			const std::pair<double, double> estimate = cat.estimateEAP();
+			theta[row] = estimate.first;
+			standardError[row] = estimate.second;
+		} catch (const std::exception &e) {
+			warnings::warn(std::string("Warning: theta could not be estimated by EAP either (") + e.what() + ").");
+		}
+	}
+
+	/**
+	 * The selector's choice, or a uniformly drawn unanswered item for RANDOM selection and, as the R loops did, when
+	 * the selector fails.
+	 */
+	int select(Cat &cat, const std::vector<int> &unanswered, std::mt19937 &engine)
+	{
+		if (!random) {
+			try {
+				return cat.nextItem();
+			} catch (const std::exception &e) {
+				warnings::warn(std::string("Warning: selection failed (") + e.what() + "); a random item was administered instead.");
+			}
+		}
+		std::uniform_int_distribution<std::size_t> pick(0, unanswered.size() - 1);
+		return unanswered[pick(engine)];
+	}
+
+	/**
+	 * The respondent's answer to item: from the response matrix (NA being a skip), or drawn at the true theta.
+	 */
+	int answer(Cat &cat, std::size_t row, int item, std::mt19937 &engine)
+	{
+		if (!sample) {
+			const int answer = responses(row, item);
+			return answer == NA_INTEGER ? -1 : answer;
+		}
+		const ModelType modelType = cat.getItemBank()->modelType;
+		const std::vector<double> probabilities = ItemTables::categoryProbabilities(cat.probability(trueTheta[row], item + 1),
+		                                                                            modelType);
+		std::discrete_distribution<int> category(probabilities.begin(), probabilities.end());
+		const bool binary = (modelType == ModelType::LTM) | (modelType == ModelType::TPM);
+		return binary ? category(engine) : category(engine) + 1;
+	}
+};
+
+//' Administers catObj adaptively to every respondent, answering from the rows of responses or, if sample is set,
+//' drawing answers at theta.  Called by simulateCat.
+//'
+//' @noRd
+// [[Rcpp::export]]
+List simulateCatBatch(S4 catObj, IntegerMatrix responses, NumericVector theta, bool sample, List options, int seed) {
+	CatOptions catOptions(options);
+	std::shared_ptr<const ItemBank> bank = std::make_shared<const ItemBank>(catObj);
+
+	std::size_t respondents = theta.size();
+	if (!sample) {
+		if ((std::size_t) responses.ncol() != bank->size()) {
+			Rcpp::stop("Cat object not compatible with responses.");
+		}
+		if (theta.size() != 0 && theta.size() != responses.nrow()) {
+			Rcpp::stop("Need a value of theta to correspond with each response profile.");
+		}
+		respondents = responses.nrow();
+
+		// Cat::storeAnswer would call Rcpp::stop on a worker, so the answers are checked here
+		const bool binary = (bank->modelType == ModelType::LTM) | (bank->modelType == ModelType::TPM);
+		for (int j = 0; j < responses.ncol(); ++j) {
+			const int min_response = binary ? 0 : 1;
+			const int max_response = binary ? 1 : (int) bank->categories[j];
+			for (int row = 0; row < responses.nrow(); ++row) {
+				const int answer = responses(row, j);
+				if (answer != NA_INTEGER && answer != -1 && (answer < min_response || answer > max_response)) {
+					Rcpp::stop("%d is not a valid answer for question %d.", answer, j + 1);
+				}
+			}
+		}
+	}
+
+	NumericVector estimates(respondents);
+	NumericVector standardError(respondents);
+	IntegerVector length(respondents);
+	NumericVector info(respondents);
+	std::vector<std::vector<int> > items(respondents);
+	if (respondents > 0) {
+		// a few blocks per thread, so that a thread finishing early can take another
+		const std::size_t blocks = std::min(respondents, 4 * mpl::threadCount());
+		std::vector<std::unique_ptr<Cat> > cats;
+		{
+			// the Cats start from catObj's answers, which every respondent replaces
+			warnings::Suppress suppress;
+			for (std::size_t block = 0; block < blocks; ++block) {
+				cats.emplace_back(new Cat(catObj, catOptions, bank));
+			}
+		}
+
+		const bool random = Rcpp::as<std::string>(catObj.slot("selection")) == "RANDOM";
+		Simulation worker(responses, theta, cats, respondents, sample, random, seed, estimates, standardError, length,
+		                  info, items);
+		mpl::parallelFor(0, blocks, worker);
+	}
+
+	return List::create(Named("theta") = estimates, Named("SE") = standardError, Named("length") = length,
+	                    Named("info") = info, Named("items") = wrap(items));
+}
@@ -0,0 +1,79 @@
+#include <Rcpp.h>
+#include <algorithm>
+#include "Cat.h"
+#include "CatTree.h"
+#include "TreeTable.h"
+using namespace Rcpp;
+
+//' Builds the branching scheme of catObj in compiled code as a table of nodes: the item asked at each node
+//' (1-indexed), and, per response option (skip first), the row of the next node or NA where the administration
+//' stops.  Called by makeTree.
+//'
+//' @noRd
+// [[Rcpp::export]]
+List makeTreeNodes(S4 catObj) {
+	Cat cat(catObj);
+	CatTree tree(cat);
+	const std::vector<CatTree::Node> &nodes = tree.getNodes();
+
+	size_t width = 0;
+	for (const CatTree::Node &node : nodes) {
+		width = std::max(width, node.children.size());
+	}
+
+	IntegerVector item(nodes.size());
+	IntegerMatrix children(nodes.size(), width);
+	std::fill(children.begin(), children.end(), NA_INTEGER);
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		item[i] = nodes[i].item + 1;
+		for (size_t k = 0; k < nodes[i].children.size(); ++k) {
+			if (nodes[i].children[k] >= 0) {
+				children(i, k) = nodes[i].children[k] + 1;
+			}
+		}
+	}
+
+	return List::create(Named("item") = item, Named("children") = children,
+	                    Named("memoized") = (int) tree.getMemoized());
+}
+
+//' Builds the branching scheme of catObj and encodes it in the binary serving format of TreeTable.  Called by
+//' exportTree.
+//'
+//' @noRd
+// [[Rcpp::export]]
+RawVector treeTableBytes(S4 catObj) {
+	Cat cat(catObj);
+	const std::vector<unsigned char> bytes = TreeTable(CatTree(cat), cat.getAnswers().size()).bytes();
+	return RawVector(bytes.begin(), bytes.end());
+}
+
+static TreeTable &treeTable(SEXP tree) {
+	if (TYPEOF(tree) != EXTPTRSXP || R_ExternalPtrTag(tree) != Rf_install("catTree")) {
+		Rcpp::stop("tree must be a catTree, as returned by loadTree().");
+	}
+	XPtr<TreeTable> ptr(tree);
+	if (ptr.get() == nullptr) {
+		Rcpp::stop("The catTree is no longer valid (loaded trees cannot be saved and reloaded). Load it again with loadTree().");
+	}
+	return *ptr;
+}
+
+//' Decodes a tree in the binary serving format.  Called by loadTree.
+//'
+//' @noRd
+// [[Rcpp::export]]
+SEXP treeTableLoad(RawVector bytes) {
+	XPtr<TreeTable> ptr(new TreeTable(std::vector<unsigned char>(bytes.begin(), bytes.end())), true, Rf_install("catTree"),
+	                    R_NilValue);
+	ptr.attr("class") = "catTree";
+	return ptr;
+}
+
+//' @rdname exportTree
+//' @export
+// [[Rcpp::export]]
+int treeNextItem(SEXP tree, IntegerVector answers) {
+	const int item = treeTable(tree).next(std::vector<int>(answers.begin(), answers.end()));
+	return item == TreeTable::STOP ? NA_INTEGER : item + 1;
+}